@@ -0,0 +1,14 @@
+dnl I'd like this to be edited in -*- Autoconf -*- mode...
+dnl
+AC_DEFUN([GST_C_THREAD_LOCAL],
+[AC_CACHE_CHECK([for thread-local variables], gst_cv_c_thread_local,
+[gst_cv_c_thread_local=no
+AC_LINK_IFELSE([AC_LANG_PROGRAM([[static __thread int foovar;]],
+                                [[return foovar++;]])],
+               [gst_cv_c_thread_local=yes])
+])
+if test $gst_cv_c_thread_local = yes; then
+  AC_DEFINE(HAVE_THREAD_LOCAL, 1,
+           [Define if the C compiler supports __thread variables])
+fi
+])# GST_C_THREAD_LOCAL
@@ -144,7 +144,7 @@ const struct tool tools[] = {
   {
     "gst-profile", "scripts/Profile.st",
     "-f|--file: -e|--eval: -o|--output: -h|--help --version \
-	--no-separate-blocks -v|-V|--verbose",
+	--no-separate-blocks -s|--sample -a|--allocations -v|-V|--verbose",
     NULL, true
   },
 
@@ -87,6 +87,10 @@ oop_array_registry;
 static oop_registry *oop_registry_root;
 static oop_array_registry *oop_array_registry_root;
 
+/* Parse and execute STR, or execute the doit that it was compiled to
+   the last time if it contained a single doit.  */
+static void eval_string (const char *str);
+
 OOP
 _gst_va_msg_send (OOP receiver,
 		  OOP selector,
@@ -399,9 +403,7 @@ _gst_eval_code (const char *str)
   if (!_gst_smalltalk_initialized)
     _gst_initialize (NULL, NULL, GST_NO_TTY);
 
-  _gst_push_cstring (str);
-  _gst_parse_stream (NULL);
-  _gst_pop_stream (true);
+  eval_string (str);
 }
 
 
@@ -413,15 +415,48 @@ _gst_eval_expr (const char *str)
   if (!_gst_smalltalk_initialized)
     _gst_initialize (NULL, NULL, GST_NO_TTY);
 
-  _gst_push_cstring (str);
-  _gst_parse_stream (NULL);
-  _gst_pop_stream (true);
+  eval_string (str);
   result = _gst_last_returned_value;
   INC_ADD_OOP (result);
 
   return (result);
 }
 
+void
+eval_string (const char *str)
+{
+  OOP namespaceOOP, methodOOP;
+  size_t len = strlen (str);
+  unsigned long errors;
+  precomp_watch watch;
+
+  namespaceOOP = _gst_current_namespace;
+  methodOOP = _gst_lookup_doit (str, len, true, _gst_undefined_object_class,
+				namespaceOOP);
+  if (!IS_NIL (methodOOP))
+    {
+      _gst_execute_doit (_gst_nil_oop, methodOOP);
+      return;
+    }
+
+  /* Only cache STR if it did nothing but executing one doit, and
+     compiled without errors.  */
+  errors = _gst_error_count;
+  _gst_precomp_watch (&watch);
+  _gst_push_cstring (str);
+  _gst_parse_stream (NULL);
+  _gst_pop_stream (true);
+
+  if (watch.events == 1
+      && watch.methodOOP
+      && IS_NIL (watch.receiverOOP)
+      && _gst_error_count == errors)
+    _gst_cache_doit (str, len, true, _gst_undefined_object_class,
+		     namespaceOOP, watch.methodOOP);
+
+  _gst_precomp_unwatch (&watch);
+}
+
 OOP
 _gst_object_alloc (OOP class_oop,
 		   int size)
@@ -65,6 +65,16 @@
 #ifdef HAVE_GETPWNAM
 #include <pwd.h>
 #endif
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
+/* The default maximum number of threads that run call-outs for
+   CCallable>>#threadedCallInto:.  */
+#define DEFAULT_MAX_CALLOUT_THREADS 8
 
 typedef struct cparam
 {
@@ -95,6 +105,21 @@ typedef struct cfunc_info
   void (*funcAddr) ();
 } cfunc_info;
 
+/* Converts OOP into CP for a marshalling stub.  Answer false if OOP
+   is not of the kind handled by the converter, so that the general
+   conversion in smalltalk_to_c is used instead.  */
+typedef mst_Boolean (*c_arg_converter) (OOP oop,
+					cparam *cp);
+
+/* One argument in a marshalling stub.  */
+typedef struct c_stub_arg
+{
+  c_arg_converter convert;	/* NULL to always use smalltalk_to_c */
+  cdata_type cType;		/* type passed to smalltalk_to_c */
+  int argIndex;			/* index in the arguments, -1 for self */
+}
+c_stub_arg;
+
 typedef struct cfunc_cif_cache
 {
   unsigned cacheGeneration;	/* Is the function called with variadic parms? */
@@ -104,9 +129,38 @@ typedef struct cfunc_cif_cache
   int arg_idx;
   cparam *args;
   ffi_type **types;
+
+  /* The marshalling stub, valid together with cacheCif: the
+     conversion for each argument, looked up once from the
+     descriptor's argument types.  */
+  c_stub_arg *stub;
+  int stubSize;
+  mst_Boolean stubPostprocessing;
 }
 cfunc_cif_cache;
 
+/* Holds a call-out that runs on a separate thread.  */
+typedef enum threaded_call_state
+{
+  THREADED_CALL_QUEUED,		/* waiting for a thread */
+  THREADED_CALL_RUNNING,	/* being executed */
+  THREADED_CALL_DONE,		/* finished, result not retrieved yet */
+  THREADED_CALL_ABANDONED	/* the process waiting for it is gone */
+} threaded_call_state;
+
+typedef struct threaded_call
+{
+  struct threaded_call *next;
+  threaded_call_state state;
+  cfunc_cif_cache marshal;	/* arguments and their types */
+  void *funcAddr;
+  void **argVec;
+  cparam result;
+  int savedErrno;
+  OOP receiverOOP;
+  OOP semaphoreOOP;		/* signaled when the call finishes */
+} threaded_call;
+
 typedef struct gst_ffi_closure
 {
   // This field must come first, since the address of this field will
@@ -156,6 +210,63 @@ static void bad_type (OOP class_oop,
 static mst_Boolean push_smalltalk_obj (OOP oop,
 				       cdata_type cType);
 
+/* Answer how many C arguments are needed to call the function
+   described by DESC, whose Smalltalk arguments start at ARGS.  Set
+   *HAVEVARIADIC and *NEEDPOSTPROCESSING according to the types of the
+   arguments.  */
+static int count_c_args (gst_c_callable desc,
+			 OOP *args,
+			 mst_Boolean *haveVariadic,
+			 mst_Boolean *needPostprocessing);
+
+/* Convert the arguments in ARGS (and RECEIVER, if it is passed too)
+   into C_FUNC_CUR, according to DESC.  Return false if one of them
+   could not be converted.  */
+static mst_Boolean push_c_args (gst_c_callable desc,
+				OOP receiver,
+				OOP *args);
+
+/* Fill in the marshalling stub in CACHE from the argument types
+   in DESC.  The function must not be variadic.  Answer false if the
+   stub cannot be used, because the C type of some argument depends
+   on the object that is passed.  */
+static mst_Boolean make_c_stub (cfunc_cif_cache *cache,
+				gst_c_callable desc,
+				mst_Boolean needPostprocessing);
+
+/* Convert the arguments in ARGS (and RECEIVER, if it is passed too)
+   into CP using the marshalling stub in CACHE.  Return the number of
+   arguments that were converted, which is less than the size of the
+   stub if one of them could not be converted.  */
+static int run_c_stub (cfunc_cif_cache *cache,
+		       OOP receiver,
+		       OOP *args,
+		       cparam *cp);
+
+/* Answer the fast converter for arguments of type CTYPE, or NULL.  */
+static c_arg_converter c_stub_converter (cdata_type cType);
+
+/* The converters used by the marshalling stubs.  */
+static mst_Boolean convert_long (OOP oop, cparam *cp);
+static mst_Boolean convert_long_long (OOP oop, cparam *cp);
+static mst_Boolean convert_int (OOP oop, cparam *cp);
+static mst_Boolean convert_uint (OOP oop, cparam *cp);
+static mst_Boolean convert_short (OOP oop, cparam *cp);
+static mst_Boolean convert_ushort (OOP oop, cparam *cp);
+static mst_Boolean convert_double (OOP oop, cparam *cp);
+static mst_Boolean convert_float (OOP oop, cparam *cp);
+static mst_Boolean convert_boolean (OOP oop, cparam *cp);
+static mst_Boolean convert_cobject (OOP oop, cparam *cp);
+static mst_Boolean convert_string (OOP oop, cparam *cp);
+static mst_Boolean convert_oop (OOP oop, cparam *cp);
+
+/* Store back the values of output arguments among the first FILLEDARGS
+   items of ARGS if SUCCEEDED is true, and free the memory allocated by
+   push_c_args.  */
+static void finish_c_args (cparam *args,
+			   int filledArgs,
+			   mst_Boolean succeeded);
+
 /* Converts the return type as stored in RESULT to an OOP, based
    on the RETURNTYPEOOP that is stored in the descriptor.  #void is
    converted to RECEIVEROOP.  */
@@ -165,6 +276,12 @@ static OOP c_to_smalltalk (cparam *result, OOP receiverOOP, OOP returnTypeOOP);
    libffi type.  */
 static ffi_type *get_ffi_type (OOP returnTypeOOP);
 
+/* Converts OOP to a C value of type CTYPE stored in CP, and answers
+   the libffi type for it, or NULL if it cannot be converted.  */
+static ffi_type *smalltalk_to_c (OOP oop,
+				 cparam *cp,
+				 cdata_type cType);
+
 /* Initializes libltdl and defines the functions to access it.  */
 static void init_dld (void);
 
@@ -172,6 +289,23 @@ static void init_dld (void);
    in the library.  */
 static PTR dld_open (const char *filename);
 
+/* Pin the objects whose address might be passed to C when OOP is
+   passed as an argument of type CTYPE, so that a garbage collection
+   can happen while a threaded call-out is running.  */
+static void fix_threaded_call_arg (OOP oop,
+				   cdata_type cType);
+
+/* Free the memory held by CALL and unregister the objects it refers
+   to, except the semaphore: that is left to threaded_call_done.  */
+static void free_threaded_call (threaded_call *call);
+
+/* Run on a separate thread the threaded call-outs that are queued.  */
+static void *threaded_call_thread (void *unused);
+
+/* Signal and unregister SEMAPHOREOOP, whose call-out has finished,
+   and free the call-outs whose process is gone.  */
+static void threaded_call_done (OOP semaphoreOOP);
+
 /* Callout to tests callins and callbacks.  */
 static void test_callin (OOP oop, int(*callback)(const char *));
 
@@ -181,6 +315,9 @@ static void test_cstring (char **string);
 /* Callout to test #cObjectPtr parameters */
 static void test_cobject_ptr (const void **string);
 
+/* Callout to measure the cost of converting common argument types */
+static long test_marshal (const void *ptr, int anInt, double aDouble);
+
 /* Return the errno on output from the last callout.  */
 static int get_errno (void);
 
@@ -203,6 +340,9 @@ static int my_symlink (const char* oldpath, const char* newpath);
 static char *my_mkdtemp (char* template);
 static int my_mkdir (const char* name, int mode);
 static DIR *my_opendir (const char *str);
+#ifdef HAVE_WAITPID
+static int my_waitpid (int pid, int nohang);
+#endif
 static char *extract_dirent_name (struct dirent *dir);
 
 /* Provide access to the arguments passed via -a.  */
@@ -221,6 +361,26 @@ static unsigned cif_cache_generation = 1;
 /* The cfunc_cif_cache that's being filled in.  */
 static cfunc_cif_cache *c_func_cur = NULL;
 
+/* The threaded call-outs waiting for a thread, and those that
+   finished after their process stopped waiting for them.  */
+static threaded_call *threaded_call_queue = NULL;
+static threaded_call **threaded_call_queue_tail = &threaded_call_queue;
+static threaded_call *abandoned_threaded_calls = NULL;
+
+/* How many threads run threaded call-outs, how many of them are
+   waiting for work, and how many can be created at most.  */
+static int threaded_call_threads = 0;
+static int idle_threaded_call_threads = 0;
+static int max_threaded_call_threads = DEFAULT_MAX_CALLOUT_THREADS;
+
+#ifndef _WIN32
+/* Protects the variables above and the STATE field of queued
+   call-outs.  The condition variable is signaled when a call-out
+   is queued.  */
+static pthread_mutex_t threaded_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t threaded_call_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
 /* printable names for corresponding C types */
 static const char *c_type_name[] = {
   "char",			/* CDATA_CHAR */
@@ -442,6 +602,31 @@ my_opendir (const char *dir)
   return (result);
 }
 
+#ifdef HAVE_WAITPID
+/* Wait for the child process PID to terminate, or only check if it did
+   when NOHANG is true.  Answer its exit status, 128 plus the number of
+   the signal that killed it, 0 if it is still running or -1 on error.  */
+int
+my_waitpid (int pid,
+	    int nohang)
+{
+  int status, result;
+
+  do
+    result = waitpid (pid, &status, nohang ? WNOHANG : 0);
+  while (result == -1 && errno == EINTR);
+
+  if (result <= 0)
+    return result;
+
+  errno = 0;
+  if (WIFSIGNALED (status))
+    return 128 + WTERMSIG (status);
+  else
+    return WEXITSTATUS (status);
+}
+#endif
+
 long long
 test_longlong (long long aVerylongInt)
 {
@@ -477,6 +662,12 @@ test_cobject_ptr (const void **string)
   *string = "this is a test";
 }
 
+long
+test_marshal (const void *ptr, int anInt, double aDouble)
+{
+  return (ptr != NULL) + anInt + (long) aDouble;
+}
+
 char *
 extract_dirent_name (struct dirent *dir)
 {
@@ -617,6 +808,7 @@ _gst_init_cfuncs (void)
   _gst_define_cfunc ("testCallin", test_callin);
   _gst_define_cfunc ("testCString", test_cstring);
   _gst_define_cfunc ("testCObjectPtr", test_cobject_ptr);
+  _gst_define_cfunc ("testMarshal", test_marshal);
 
   /* Access to C library */
   _gst_define_cfunc ("system", system);
@@ -650,6 +842,13 @@ _gst_init_cfuncs (void)
   _gst_define_cfunc ("mkdtemp", my_mkdtemp);
   _gst_define_cfunc ("getCurDirName", _gst_get_cur_dir_name);
 
+#ifdef HAVE_FORK
+  _gst_define_cfunc ("kill", kill);
+#endif
+#ifdef HAVE_WAITPID
+  _gst_define_cfunc ("waitpid", my_waitpid);
+#endif
+
   _gst_define_cfunc ("fileIsReadable", _gst_file_is_readable);
   _gst_define_cfunc ("fileIsWriteable", _gst_file_is_writeable);
   _gst_define_cfunc ("fileIsExecutable", _gst_file_is_executable);
@@ -799,41 +998,20 @@ _gst_invalidate_croutine_cache (void)
   cif_cache_generation += 2;
 }
 
-OOP
-_gst_invoke_croutine (OOP cFuncOOP,
-		      OOP receiver,
-		      OOP *args)
+int
+count_c_args (gst_c_callable desc,
+	      OOP *args,
+	      mst_Boolean *haveVariadic,
+	      mst_Boolean *needPostprocessing)
 {
-  gst_c_callable desc;
   cdata_type cType;
-  cparam result, *local_arg_vec, *arg;
-  void *funcAddr, **p_slot, **ffi_arg_vec;
   OOP *argTypes, oop;
-  int i, si, fixedArgs, totalArgs, filledArgs;
-  mst_Boolean haveVariadic, needPostprocessing;
-  inc_ptr incPtr;
-
-  incPtr = INC_SAVE_POINTER ();
-
-  /* Make sure the parameters do not die.  */
-  INC_ADD_OOP (cFuncOOP);
-  INC_ADD_OOP (receiver);
-
-  funcAddr = cobject_value (cFuncOOP);
-  if (!funcAddr)
-    return (NULL);
-
-  p_slot = pointer_map_insert (cif_cache, cFuncOOP);
-  if (!*p_slot)
-    *p_slot = xcalloc (1, sizeof (cfunc_cif_cache));
+  int i, si, fixedArgs, totalArgs;
 
-  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
   argTypes = OOP_TO_OBJ (desc->argTypesOOP)->data;
-
-  c_func_cur = *p_slot;
   fixedArgs = NUM_INDEXABLE_FIELDS (desc->argTypesOOP);
   totalArgs = 0;
-  haveVariadic = needPostprocessing = false;
+  *haveVariadic = *needPostprocessing = false;
   for (si = i = 0; i < fixedArgs; i++)
     {
       cType = IS_OOP (argTypes[i]) ? CDATA_COBJECT : TO_INT (argTypes[i]);
@@ -846,7 +1024,7 @@ _gst_invoke_croutine (OOP cFuncOOP,
 	case CDATA_VARIADIC_OOP:
 	  oop = args[si++];
 	  totalArgs += NUM_WORDS (OOP_TO_OBJ (oop));
-	  haveVariadic = true;
+	  *haveVariadic = true;
 	  break;
 
         case CDATA_SELF:
@@ -863,7 +1041,7 @@ _gst_invoke_croutine (OOP cFuncOOP,
         case CDATA_BYTEARRAY:
         case CDATA_SYMBOL:
         case CDATA_WSTRING:
-	  needPostprocessing = true;
+	  *needPostprocessing = true;
 	  /* fall through */
 
 	default:
@@ -873,24 +1051,20 @@ _gst_invoke_croutine (OOP cFuncOOP,
 	}
     }
 
-  ffi_arg_vec = (void **) alloca (totalArgs * sizeof (void *));
-  c_func_cur->args = local_arg_vec = (cparam *)
-    alloca (totalArgs * sizeof (cparam));
-
-  /* The ffi_cif holds a pointer to this, so we must malloc it.  */
-  if (c_func_cur->types_size < totalArgs)
-    {
-      c_func_cur->types = (ffi_type **) realloc (c_func_cur->types,
-					         totalArgs * sizeof (ffi_type *));
-      c_func_cur->types_size = totalArgs;
-    }
-
-  c_func_cur->arg_idx = 0;
+  return totalArgs;
+}
 
-  for (i = 0; i < totalArgs; i++)
-    ffi_arg_vec[i] = &local_arg_vec[i].u;
+mst_Boolean
+push_c_args (gst_c_callable desc,
+	     OOP receiver,
+	     OOP *args)
+{
+  cdata_type cType;
+  OOP *argTypes;
+  int i, si, fixedArgs;
 
-  /* Push the arguments */
+  argTypes = OOP_TO_OBJ (desc->argTypesOOP)->data;
+  fixedArgs = NUM_INDEXABLE_FIELDS (desc->argTypesOOP);
   for (si = i = 0; i < fixedArgs; i++)
     {
       mst_Boolean res;
@@ -907,30 +1081,152 @@ _gst_invoke_croutine (OOP cFuncOOP,
 	res = push_smalltalk_obj (args[si++], cType);
 
       if (!res)
-        {
-          oop = NULL;
-	  filledArgs = c_func_cur->arg_idx;
-          goto out;
-        }
+	return false;
     }
 
-  /* If the previous call was done through the same function descriptor,
-     the ffi_cif is already ok.  */
-  if (c_func_cur->cacheGeneration != cif_cache_generation)
+  return true;
+}
+
+void
+finish_c_args (cparam *args,
+	       int filledArgs,
+	       mst_Boolean succeeded)
+{
+  cparam *arg;
+  int i;
+
+  /* Fixup all returned string variables */
+  for (i = 0, arg = args; i < filledArgs; i++, arg++)
     {
-      ffi_prep_cif (&c_func_cur->cacheCif, FFI_DEFAULT_ABI, totalArgs,
-                    get_ffi_type (desc->returnTypeOOP),
-		    c_func_cur->types);
-
-      /* For variadic functions, we cannot cache the ffi_cif because
-	 the argument types change every time.  */
-      if (!haveVariadic)
-	c_func_cur->cacheGeneration = cif_cache_generation;
+      if (!arg->oop)
+	continue;
+
+      switch (arg->cType)
+	{
+	case CDATA_COBJECT_PTR:
+	  if (succeeded)
+	    set_cobject_value (arg->oop, arg->u.cObjectPtrVal.ptrVal);
+	  continue;
+
+	case CDATA_WSTRING_OUT:
+	  if (succeeded)
+	    _gst_set_oop_unicode_string (arg->oop, arg->u.ptrVal);
+	  break;
+
+	case CDATA_STRING_OUT:
+	  if (succeeded)
+	    _gst_set_oopstring (arg->oop, arg->u.ptrVal);
+	  break;
+
+	case CDATA_BYTEARRAY_OUT:
+	  if (succeeded)
+	    _gst_set_oop_bytes (arg->oop, arg->u.ptrVal);
+	  break;
+
+	default:
+	  break;
+	}
+
+      xfree (arg->u.ptrVal);
     }
+}
+
+OOP
+_gst_invoke_croutine (OOP cFuncOOP,
+		      OOP receiver,
+		      OOP *args)
+{
+  gst_c_callable desc;
+  cparam result, *local_arg_vec;
+  void *funcAddr, **p_slot, **ffi_arg_vec;
+  OOP oop;
+  int i, totalArgs, filledArgs;
+  mst_Boolean haveVariadic, needPostprocessing;
+  inc_ptr incPtr;
+
+  incPtr = INC_SAVE_POINTER ();
+
+  /* Make sure the parameters do not die.  */
+  INC_ADD_OOP (cFuncOOP);
+  INC_ADD_OOP (receiver);
+
+  funcAddr = cobject_value (cFuncOOP);
+  if (!funcAddr)
+    return (NULL);
+
+  p_slot = pointer_map_insert (cif_cache, cFuncOOP);
+  if (!*p_slot)
+    *p_slot = xcalloc (1, sizeof (cfunc_cif_cache));
+
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  c_func_cur = *p_slot;
+
+  /* If the function was already called through the same function
+     descriptor, the ffi_cif is already ok and the stub knows how to
+     convert the arguments.  */
+  if (c_func_cur->cacheGeneration == cif_cache_generation)
+    {
+      totalArgs = c_func_cur->stubSize;
+      needPostprocessing = c_func_cur->stubPostprocessing;
+      ffi_arg_vec = (void **) alloca (totalArgs * sizeof (void *));
+      local_arg_vec = (cparam *) alloca (totalArgs * sizeof (cparam));
+      for (i = 0; i < totalArgs; i++)
+        ffi_arg_vec[i] = &local_arg_vec[i].u;
+
+      filledArgs = run_c_stub (c_func_cur, receiver, args, local_arg_vec);
+      if (filledArgs < totalArgs)
+	{
+	  oop = NULL;
+	  goto out;
+	}
+
+      goto call;
+    }
+
+  totalArgs = count_c_args (desc, args, &haveVariadic, &needPostprocessing);
+
+  ffi_arg_vec = (void **) alloca (totalArgs * sizeof (void *));
+  c_func_cur->args = local_arg_vec = (cparam *)
+    alloca (totalArgs * sizeof (cparam));
+
+  /* The ffi_cif holds a pointer to this, so we must malloc it.  */
+  if (c_func_cur->types_size < totalArgs)
+    {
+      c_func_cur->types = (ffi_type **) realloc (c_func_cur->types,
+					         totalArgs * sizeof (ffi_type *));
+      c_func_cur->types_size = totalArgs;
+    }
+
+  c_func_cur->arg_idx = 0;
+
+  for (i = 0; i < totalArgs; i++)
+    ffi_arg_vec[i] = &local_arg_vec[i].u;
+
+  /* Push the arguments */
+  if (!push_c_args (desc, receiver, args))
+    {
+      oop = NULL;
+      filledArgs = c_func_cur->arg_idx;
+      goto out;
+    }
+
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  ffi_prep_cif (&c_func_cur->cacheCif, FFI_DEFAULT_ABI, totalArgs,
+		get_ffi_type (desc->returnTypeOOP),
+		c_func_cur->types);
+
+  /* For variadic functions, we cannot cache the ffi_cif because
+     the argument types change every time.  The same is true of
+     #unknown and #self arguments.  */
+  if (!haveVariadic
+      && make_c_stub (c_func_cur, desc, needPostprocessing))
+    c_func_cur->cacheGeneration = cif_cache_generation;
 
-  errno = 0;
   filledArgs = c_func_cur->arg_idx;
   assert (filledArgs == totalArgs);
+
+ call:
+  errno = 0;
   ffi_call (&c_func_cur->cacheCif, FFI_FN (funcAddr), &result.u, ffi_arg_vec);
 
   _gst_set_errno (errno);
@@ -939,46 +1235,642 @@ _gst_invoke_croutine (OOP cFuncOOP,
   INC_ADD_OOP (oop);
 
  out:
-  /* Fixup all returned string variables */
   if (needPostprocessing)
-    for (i = 0, arg = local_arg_vec; i < filledArgs; i++, arg++)
-      {
-        if (!arg->oop)
+    finish_c_args (local_arg_vec, filledArgs, oop != NULL);
+
+  INC_RESTORE_POINTER (incPtr);
+  return (oop);
+}
+
+mst_Boolean
+make_c_stub (cfunc_cif_cache *cache,
+	     gst_c_callable desc,
+	     mst_Boolean needPostprocessing)
+{
+  cdata_type cType;
+  c_stub_arg *arg;
+  OOP *argTypes;
+  int i, si, fixedArgs;
+
+  argTypes = OOP_TO_OBJ (desc->argTypesOOP)->data;
+  fixedArgs = NUM_INDEXABLE_FIELDS (desc->argTypesOOP);
+  cache->stub = (c_stub_arg *) xrealloc (cache->stub,
+					 (fixedArgs + 1) * sizeof (c_stub_arg));
+
+  for (arg = cache->stub, si = i = 0; i < fixedArgs; i++)
+    {
+      cType = IS_OOP (argTypes[i]) ? CDATA_COBJECT : TO_INT (argTypes[i]);
+      if (cType == CDATA_VOID)
+	continue;
+
+      if (cType == CDATA_SELF || cType == CDATA_SELF_OOP)
+	{
+	  arg->argIndex = -1;
+	  arg->cType = cType == CDATA_SELF ? CDATA_UNKNOWN : CDATA_OOP;
+	}
+      else
+	{
+	  arg->argIndex = si++;
+	  arg->cType = cType;
+	}
+
+      if (arg->cType == CDATA_UNKNOWN)
+	return (false);
+
+      arg->convert = c_stub_converter (arg->cType);
+      arg++;
+    }
+
+  cache->stubSize = arg - cache->stub;
+  cache->stubPostprocessing = needPostprocessing;
+  return (true);
+}
+
+int
+run_c_stub (cfunc_cif_cache *cache,
+	    OOP receiver,
+	    OOP *args,
+	    cparam *cp)
+{
+  c_stub_arg *arg;
+  OOP oop;
+  int i;
+
+  for (i = 0, arg = cache->stub; i < cache->stubSize; i++, arg++, cp++)
+    {
+      oop = arg->argIndex < 0 ? receiver : args[arg->argIndex];
+      cp->oop = NULL;
+      if (arg->convert && arg->convert (oop, cp))
+	{
+	  cp->cType = arg->cType;
 	  continue;
+	}
+
+      if (!smalltalk_to_c (oop, cp, arg->cType))
+	break;
+      if (cp->oop && !IS_NIL (cp->oop))
+	INC_ADD_OOP (cp->oop);
+    }
+
+  return i;
+}
+
+c_arg_converter
+c_stub_converter (cdata_type cType)
+{
+  switch (cType)
+    {
+    case CDATA_LONG:
+    case CDATA_ULONG:
+      return convert_long;
+
+    case CDATA_LONGLONG:
+    case CDATA_ULONGLONG:
+      return convert_long_long;
+
+    case CDATA_INT:
+      return convert_int;
+
+    case CDATA_UINT:
+      return convert_uint;
+
+    case CDATA_SHORT:
+      return convert_short;
+
+    case CDATA_USHORT:
+      return convert_ushort;
+
+    case CDATA_DOUBLE:
+      return convert_double;
+
+    case CDATA_FLOAT:
+      return convert_float;
+
+    case CDATA_BOOLEAN:
+      return convert_boolean;
+
+    case CDATA_COBJECT:
+      return convert_cobject;
+
+    case CDATA_STRING:
+      return convert_string;
+
+    case CDATA_OOP:
+      return convert_oop;
+
+    default:
+      return NULL;
+    }
+}
+
+mst_Boolean
+convert_long (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longVal = TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_long_long (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longLongVal = TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_int (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longVal = (int) TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_uint (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longVal = (unsigned int) TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_short (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longVal = (short) TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_ushort (OOP oop, cparam *cp)
+{
+  if (!IS_INT (oop))
+    return false;
+
+  cp->u.longVal = (unsigned short) TO_INT (oop);
+  return true;
+}
+
+mst_Boolean
+convert_double (OOP oop, cparam *cp)
+{
+  if (IS_INT (oop))
+    cp->u.doubleVal = (double) TO_INT (oop);
+  else if (OOP_CLASS (oop) == _gst_floatd_class)
+    cp->u.doubleVal = FLOATD_OOP_VALUE (oop);
+  else
+    return false;
+
+  return true;
+}
 
-	switch (arg->cType)
-          {
-          case CDATA_COBJECT_PTR:
-            if (oop)
-              set_cobject_value (arg->oop, arg->u.cObjectPtrVal.ptrVal);
-            continue;
+mst_Boolean
+convert_float (OOP oop, cparam *cp)
+{
+  if (IS_INT (oop))
+    cp->u.floatVal = (float) TO_INT (oop);
+  else if (OOP_CLASS (oop) == _gst_floatd_class)
+    cp->u.floatVal = (float) FLOATD_OOP_VALUE (oop);
+  else
+    return false;
 
-          case CDATA_WSTRING_OUT:
-            if (oop)
-              _gst_set_oop_unicode_string (arg->oop, arg->u.ptrVal);
-            break;
+  return true;
+}
 
-          case CDATA_STRING_OUT:
-            if (oop)
-              _gst_set_oopstring (arg->oop, arg->u.ptrVal);
-            break;
+mst_Boolean
+convert_boolean (OOP oop, cparam *cp)
+{
+  if (oop != _gst_true_oop && oop != _gst_false_oop)
+    return false;
+
+  cp->u.longVal = (oop == _gst_true_oop);
+  return true;
+}
+
+mst_Boolean
+convert_cobject (OOP oop, cparam *cp)
+{
+  if (IS_NIL (oop))
+    cp->u.ptrVal = NULL;
+  else if (IS_OOP (oop)
+	   && is_a_kind_of (OOP_CLASS (oop), _gst_c_object_class))
+    cp->u.ptrVal = cobject_value (oop);
+  else
+    return false;
 
-          case CDATA_BYTEARRAY_OUT:
-            if (oop)
-              _gst_set_oop_bytes (arg->oop, arg->u.ptrVal);
-            break;
+  return true;
+}
 
-          default:
-            break;
-          }
+mst_Boolean
+convert_string (OOP oop, cparam *cp)
+{
+  if (IS_NIL (oop))
+    cp->u.ptrVal = NULL;
+  else if (IS_OOP (oop)
+	   && (OOP_CLASS (oop) == _gst_string_class
+	       || OOP_CLASS (oop) == _gst_symbol_class))
+    {
+      cp->oop = oop;
+      cp->u.ptrVal = (gst_uchar *) _gst_to_cstring (oop);
+      INC_ADD_OOP (oop);
+    }
+  else
+    return false;
 
-        xfree (arg->u.ptrVal);
-      }
+  return true;
+}
+
+mst_Boolean
+convert_oop (OOP oop, cparam *cp)
+{
+  cp->u.ptrVal = (PTR) oop;
+  INC_ADD_OOP (oop);
+  return true;
+}
+
+void
+fix_threaded_call_arg (OOP oop,
+		       cdata_type cType)
+{
+  OOP class;
+  int i;
+
+  if (IS_INT (oop) || IS_NIL (oop)
+      || oop == _gst_true_oop || oop == _gst_false_oop)
+    return;
+
+  class = OOP_CLASS (oop);
+  switch (cType)
+    {
+    case CDATA_VARIADIC:
+    case CDATA_VARIADIC_OOP:
+      if (class == _gst_array_class)
+	for (i = 1; i <= NUM_WORDS (OOP_TO_OBJ (oop)); i++)
+	  fix_threaded_call_arg (ARRAY_AT (oop, i),
+				 cType == CDATA_VARIADIC
+				 ? CDATA_UNKNOWN : CDATA_OOP);
+      return;
+
+    case CDATA_UNKNOWN:
+      /* Strings, numbers and characters are copied, everything else
+	 is passed as a CObject or as an OOP.  */
+      if (class == _gst_char_class
+	  || class == _gst_unicode_character_class
+	  || class == _gst_byte_array_class
+	  || is_a_kind_of (class, _gst_number_class)
+	  || is_a_kind_of (class, _gst_string_class)
+	  || is_a_kind_of (class, _gst_unicode_string_class))
+	return;
+
+      /* fall through */
+
+    case CDATA_COBJECT:
+    case CDATA_COBJECT_PTR:
+      if (is_a_kind_of (class, _gst_c_object_class))
+	{
+	  OOP storageOOP = ((gst_cobject) OOP_TO_OBJ (oop))->storage;
+	  if (!IS_NIL (storageOOP))
+	    _gst_make_oop_fixed (storageOOP);
+	  return;
+	}
+
+      /* fall through */
+
+    case CDATA_OOP:
+    case CDATA_SELF_OOP:
+      _gst_make_oop_fixed (oop);
+      return;
+
+    default:
+      return;
+    }
+}
+
+PTR
+_gst_start_threaded_croutine (OOP cFuncOOP,
+			      OOP receiver,
+			      OOP *args,
+			      OOP semaphoreOOP)
+{
+  gst_c_callable desc;
+  threaded_call *call;
+  cdata_type cType;
+  OOP *argTypes;
+  void *funcAddr;
+  int i, si, fixedArgs, totalArgs;
+  mst_Boolean haveVariadic, needPostprocessing;
+  inc_ptr incPtr;
+
+  funcAddr = cobject_value (cFuncOOP);
+  if (!funcAddr)
+    return (NULL);
+
+  incPtr = INC_SAVE_POINTER ();
+  INC_ADD_OOP (cFuncOOP);
+  INC_ADD_OOP (receiver);
+
+  /* ARGS points into a context, which can move while the objects are
+     fixed below, so copy them first.  */
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  fixedArgs = NUM_INDEXABLE_FIELDS (desc->argTypesOOP);
+  argTypes = OOP_TO_OBJ (desc->argTypesOOP)->data;
+  for (si = i = 0; i < fixedArgs; i++)
+    {
+      cType = IS_OOP (argTypes[i]) ? CDATA_COBJECT : TO_INT (argTypes[i]);
+      if (cType != CDATA_SELF && cType != CDATA_SELF_OOP
+	  && cType != CDATA_VOID)
+	si++;
+    }
+
+  args = memcpy (alloca (sizeof (OOP) * (si + 1)), args, sizeof (OOP) * si);
+  for (i = 0; i < si; i++)
+    INC_ADD_OOP (args[i]);
+
+  /* The C function will run while the interpreter goes on, so fix
+     in memory the objects it can access by address.  Do this before
+     converting the arguments, because it moves the objects.  */
+  for (si = i = 0; i < fixedArgs; i++)
+    {
+      desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+      argTypes = OOP_TO_OBJ (desc->argTypesOOP)->data;
+      cType = IS_OOP (argTypes[i]) ? CDATA_COBJECT : TO_INT (argTypes[i]);
+      if (cType == CDATA_SELF || cType == CDATA_SELF_OOP)
+	fix_threaded_call_arg (receiver,
+			       cType == CDATA_SELF ? CDATA_UNKNOWN : CDATA_OOP);
+      else if (cType != CDATA_VOID)
+	fix_threaded_call_arg (args[si++], cType);
+    }
+
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  totalArgs = count_c_args (desc, args, &haveVariadic, &needPostprocessing);
+
+  /* Unlike _gst_invoke_croutine, everything lives in the heap because
+     the call outlives the primitive.  */
+  call = (threaded_call *) xcalloc (1, sizeof (threaded_call));
+  call->funcAddr = funcAddr;
+  call->marshal.args = (cparam *) xcalloc (totalArgs + 1, sizeof (cparam));
+  call->marshal.types = (ffi_type **) xcalloc (totalArgs + 1,
+					       sizeof (ffi_type *));
+  call->marshal.types_size = totalArgs;
+  call->argVec = (void **) xmalloc ((totalArgs + 1) * sizeof (void *));
+  for (i = 0; i < totalArgs; i++)
+    call->argVec[i] = &call->marshal.args[i].u;
+
+  c_func_cur = &call->marshal;
+  if (!push_c_args (desc, receiver, args))
+    {
+      finish_c_args (call->marshal.args, call->marshal.arg_idx, false);
+      call->marshal.arg_idx = 0;
+      free_threaded_call (call);
+      INC_RESTORE_POINTER (incPtr);
+      return (NULL);
+    }
+
+  assert (call->marshal.arg_idx == totalArgs);
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  ffi_prep_cif (&call->marshal.cacheCif, FFI_DEFAULT_ABI, totalArgs,
+		get_ffi_type (desc->returnTypeOOP), call->marshal.types);
+
+  /* Keep alive what the call refers to until the result is retrieved.  */
+  call->receiverOOP = _gst_register_oop (receiver);
+  call->semaphoreOOP = _gst_register_oop (semaphoreOOP);
+  for (i = 0; i < totalArgs; i++)
+    {
+      cparam *arg = &call->marshal.args[i];
+      if (arg->oop)
+	_gst_register_oop (arg->oop);
+      if (arg->cType == CDATA_OOP)
+	_gst_register_oop ((OOP) arg->u.ptrVal);
+    }
 
   INC_RESTORE_POINTER (incPtr);
+
+#ifdef _WIN32
+  /* No thread pool here, so just run it and pretend it was quick.  */
+  errno = 0;
+  ffi_call (&call->marshal.cacheCif, FFI_FN (call->funcAddr),
+	    &call->result.u, call->argVec);
+  call->savedErrno = errno;
+  call->state = THREADED_CALL_DONE;
+  _gst_async_signal_and_unregister (call->semaphoreOOP);
+#else
+  pthread_mutex_lock (&threaded_call_mutex);
+  call->state = THREADED_CALL_QUEUED;
+  *threaded_call_queue_tail = call;
+  threaded_call_queue_tail = &call->next;
+
+  if (idle_threaded_call_threads == 0
+      && threaded_call_threads < max_threaded_call_threads)
+    {
+      pthread_attr_t attr;
+      pthread_t thread;
+      pthread_attr_init (&attr);
+      pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+      if (pthread_create (&thread, &attr, threaded_call_thread, NULL) == 0)
+	threaded_call_threads++;
+      pthread_attr_destroy (&attr);
+    }
+
+  pthread_cond_signal (&threaded_call_cond);
+  pthread_mutex_unlock (&threaded_call_mutex);
+#endif
+
+  return (call);
+}
+
+OOP
+_gst_finish_threaded_croutine (OOP cFuncOOP,
+			       PTR callPtr)
+{
+  threaded_call *call = (threaded_call *) callPtr;
+  gst_c_callable desc;
+  OOP oop;
+  inc_ptr incPtr;
+
+#ifndef _WIN32
+  pthread_mutex_lock (&threaded_call_mutex);
+  if (call->state != THREADED_CALL_DONE)
+    {
+      /* Let threaded_call_done free it when the thread is done.  */
+      call->state = THREADED_CALL_ABANDONED;
+      pthread_mutex_unlock (&threaded_call_mutex);
+      return (NULL);
+    }
+
+  pthread_mutex_unlock (&threaded_call_mutex);
+#endif
+
+  incPtr = INC_SAVE_POINTER ();
+  _gst_set_errno (call->savedErrno);
+  desc = (gst_c_callable) OOP_TO_OBJ (cFuncOOP);
+  oop = c_to_smalltalk (&call->result, call->receiverOOP,
+			desc->returnTypeOOP);
+  INC_ADD_OOP (oop);
+
+  finish_c_args (call->marshal.args, call->marshal.arg_idx, true);
+  free_threaded_call (call);
+  INC_RESTORE_POINTER (incPtr);
   return (oop);
 }
 
+void
+_gst_reset_threaded_croutines (void)
+{
+#ifndef _WIN32
+  threaded_call *call;
+  int n;
+
+  /* The threads that ran the call-outs were not copied to the child,
+     and one of them could have held the mutex.  */
+  pthread_mutex_init (&threaded_call_mutex, NULL);
+  pthread_cond_init (&threaded_call_cond, NULL);
+  threaded_call_threads = 0;
+  idle_threaded_call_threads = 0;
+
+  /* Start new threads for the call-outs that were still queued.  */
+  for (n = 0, call = threaded_call_queue;
+       call && n < max_threaded_call_threads; n++, call = call->next)
+    {
+      pthread_attr_t attr;
+      pthread_t thread;
+      pthread_attr_init (&attr);
+      pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+      if (pthread_create (&thread, &attr, threaded_call_thread, NULL) == 0)
+	threaded_call_threads++;
+      pthread_attr_destroy (&attr);
+    }
+#endif
+}
+
+int
+_gst_set_max_threaded_croutines (int n)
+{
+  int old = max_threaded_call_threads;
+  if (n > 0)
+    max_threaded_call_threads = n;
+
+  return (old);
+}
+
+void
+free_threaded_call (threaded_call *call)
+{
+  int i;
+
+  for (i = 0; i < call->marshal.arg_idx; i++)
+    {
+      cparam *arg = &call->marshal.args[i];
+      if (arg->oop)
+	_gst_unregister_oop (arg->oop);
+      if (arg->cType == CDATA_OOP)
+	_gst_unregister_oop ((OOP) arg->u.ptrVal);
+    }
+
+  if (call->receiverOOP)
+    _gst_unregister_oop (call->receiverOOP);
+
+  xfree (call->marshal.args);
+  xfree (call->marshal.types);
+  xfree (call->argVec);
+  xfree (call);
+}
+
+void
+threaded_call_done (OOP semaphoreOOP)
+{
+  threaded_call *call;
+
+  /* The call-out can be freed before this runs, so it does not own
+     the semaphore.  */
+  _gst_sync_signal (semaphoreOOP, true);
+  _gst_unregister_oop (semaphoreOOP);
+
+#ifndef _WIN32
+  pthread_mutex_lock (&threaded_call_mutex);
+  call = abandoned_threaded_calls;
+  abandoned_threaded_calls = NULL;
+  pthread_mutex_unlock (&threaded_call_mutex);
+
+  while (call)
+    {
+      threaded_call *next = call->next;
+      finish_c_args (call->marshal.args, call->marshal.arg_idx, false);
+      free_threaded_call (call);
+      call = next;
+    }
+#endif
+}
+
+void *
+threaded_call_thread (void *unused)
+{
+#ifndef _WIN32
+  threaded_call *call;
+  sigset_t set;
+
+  /* Leave the signals used by the VM to the interpreter thread.  */
+  sigfillset (&set);
+  pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+  pthread_mutex_lock (&threaded_call_mutex);
+  for (;;)
+    {
+      while (!threaded_call_queue)
+	{
+	  idle_threaded_call_threads++;
+	  pthread_cond_wait (&threaded_call_cond, &threaded_call_mutex);
+	  idle_threaded_call_threads--;
+	}
+
+      call = threaded_call_queue;
+      threaded_call_queue = call->next;
+      if (!threaded_call_queue)
+	threaded_call_queue_tail = &threaded_call_queue;
+
+      call->next = NULL;
+
+      /* Do not start calls whose process is already gone.  */
+      if (call->state != THREADED_CALL_ABANDONED)
+	{
+	  call->state = THREADED_CALL_RUNNING;
+	  pthread_mutex_unlock (&threaded_call_mutex);
+
+	  errno = 0;
+	  ffi_call (&call->marshal.cacheCif, FFI_FN (call->funcAddr),
+		    &call->result.u, call->argVec);
+	  call->savedErrno = errno;
+	  pthread_mutex_lock (&threaded_call_mutex);
+	}
+
+      /* The semaphore is read before unlocking, because the call
+	 can be freed as soon as its state changes.  */
+      if (call->state == THREADED_CALL_ABANDONED)
+	{
+	  call->next = abandoned_threaded_calls;
+	  abandoned_threaded_calls = call;
+	}
+      else
+	call->state = THREADED_CALL_DONE;
+
+      _gst_async_call (threaded_call_done, call->semaphoreOOP);
+    }
+#endif
+
+  return NULL;
+}
+
 ffi_type *
 get_ffi_type (OOP returnTypeOOP)
 {
@@ -135,6 +135,40 @@ extern OOP _gst_invoke_croutine (OOP cFuncOOP,
 				 OOP *args) 
   ATTRIBUTE_HIDDEN;
 
+/* Starts invoking a C routine on a separate thread, so that the
+   interpreter can run other processes while it blocks.  Arguments are
+   the same as _gst_invoke_croutine; the objects whose address is
+   passed to C are moved to fixed space.  SEMAPHOREOOP is signaled
+   when the call ends.  The result is NULL if the arguments could
+   not be converted, a handle to be passed to
+   _gst_finish_threaded_croutine otherwise.  */
+extern PTR _gst_start_threaded_croutine (OOP cFuncOOP,
+					 OOP receiver,
+					 OOP *args,
+					 OOP semaphoreOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Answer an OOP holding the result of the call CALL, started with
+   _gst_start_threaded_croutine on the descriptor CFUNCOOP, and free
+   CALL.  If the call has not finished yet, answer NULL and let the
+   thread free it when it finishes.  */
+extern OOP _gst_finish_threaded_croutine (OOP cFuncOOP,
+					  PTR call)
+  ATTRIBUTE_HIDDEN;
+
+/* Called in the child process after fork, which does not have the
+   threads that run threaded C routines: empty the pool and start
+   new threads for the calls that were waiting for one.  Calls that
+   were running at the time of the fork never finish in the child.  */
+extern void _gst_reset_threaded_croutines (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Set to N the maximum number of threads that run threaded C
+   routines, and answer the previous value.  N <= 0 only answers the
+   current value.  */
+extern int _gst_set_max_threaded_croutines (int n)
+  ATTRIBUTE_HIDDEN;
+
 /* Defines the mapping between a string function name FUNCNAME and the
    address FUNCADDR of that function, for later use in
    lookup_function.  The mapping table will expand as needed to
@@ -71,6 +71,10 @@
 
 #define LITERAL_VEC_CHUNK_SIZE		32
 
+/* The number of doits that are kept by the doit cache.  Must be a
+   power of two.  */
+#define DOIT_CACHE_SIZE			256
+
 
 typedef struct method_attributes
 {
@@ -79,6 +83,23 @@ typedef struct method_attributes
   OOP oop;
 } method_attributes;
 
+/* An entry of the doit cache.  SOURCE is a copy of the LEN bytes of
+   code that METHODOOP was compiled from, and CHUNK tells whether it
+   was parsed like a file-in or compiled as the body of a method.
+   INSTVARSOOP holds the instance variable names of CLASSOOP at the
+   time the doit was compiled.  All the OOPs are registered with the
+   garbage collector.  */
+typedef struct doit_cache_entry
+{
+  char *source;
+  size_t len;
+  mst_Boolean chunk;
+  OOP classOOP;
+  OOP instVarsOOP;
+  OOP namespaceOOP;
+  OOP methodOOP;
+} doit_cache_entry;
+
 /* These hold the compiler's notions of the current class for
    compilations, and the current category that compiled methods are to
    be placed into.  */
@@ -389,6 +410,41 @@ static OOP termination_method;
 
 /* The linked list of attributes that are specified by the method.  */
 static method_attributes *method_attrs = NULL;
+
+/* The doits that were compiled by gst_eval_code, gst_eval_expr and
+   Behavior>>#evaluate:, indexed by doit_cache_index.  */
+static doit_cache_entry doit_cache[DOIT_CACHE_SIZE];
+
+/* Run the doit METHODOOP with RECEIVEROOP as the receiver, or just
+   answer RESULTOOP if METHODOOP is nil, and print the result unless
+   QUIET is true.  */
+static OOP execute_doit_method (OOP receiverOOP,
+				OOP methodOOP,
+				OOP resultOOP,
+				mst_Boolean quiet);
+
+/* Answer the index in the doit cache for the LEN bytes at SOURCE,
+   compiled for CLASSOOP in NAMESPACEOOP.  */
+static inline int doit_cache_index (const char *source,
+				    size_t len,
+				    OOP classOOP,
+				    OOP namespaceOOP);
+
+/* Answer whether the variable bindings used by the CompiledCode
+   object CODEOOP are still the ones that compiling it again would
+   find by looking up their names in POOLS.  Bindings that are
+   created by the parser for undeclared variables are never
+   considered valid.  */
+static mst_Boolean are_doit_bindings_valid (OOP codeOOP,
+					    pool_list pools);
+
+/* Likewise, but compute the pools for a doit compiled for CLASSOOP
+   in NAMESPACEOOP.  CHUNK is true for gst_eval_code, which compiles
+   in the current namespace like the doits in a file.  */
+static mst_Boolean is_doit_valid (OOP codeOOP,
+				  mst_Boolean chunk,
+				  OOP classOOP,
+				  OOP namespaceOOP);
 
 
 /* Exit a really losing compilation */
@@ -507,11 +563,6 @@ _gst_execute_statements (OOP receiverOOP,
 			 mst_Boolean quiet)
 {
   tree_node statements;
-  int startTime, endTime, deltaTime;
-  unsigned long cacheHits;
-#ifdef HAVE_GETRUSAGE
-  struct rusage startRusage, endRusage;
-#endif
   OOP methodOOP, resultOOP;
   inc_ptr incPtr;
 
@@ -563,11 +614,40 @@ _gst_execute_statements (OOP receiverOOP,
     }
 
   INC_ADD_OOP (methodOOP);
+  resultOOP = execute_doit_method (receiverOOP, methodOOP, resultOOP, quiet);
+  INC_RESTORE_POINTER (incPtr);
+  return (resultOOP);
+}
+
+OOP
+_gst_execute_doit (OOP receiverOOP,
+		   OOP methodOOP)
+{
+  return (execute_doit_method (receiverOOP, methodOOP, _gst_nil_oop, true));
+}
+
+OOP
+execute_doit_method (OOP receiverOOP,
+		     OOP methodOOP,
+		     OOP resultOOP,
+		     mst_Boolean quiet)
+{
+  int startTime, endTime, deltaTime;
+  unsigned long cacheHits;
+#ifdef HAVE_GETRUSAGE
+  struct rusage startRusage, endRusage;
+#endif
+  inc_ptr incPtr;
+  int level;
 
+  incPtr = INC_SAVE_POINTER ();
   if (!_gst_raw_profile)
-    _gst_bytecode_counter = _gst_primitives_executed =
-      _gst_self_returns = _gst_inst_var_returns = _gst_literal_returns =
-      _gst_sample_counter = 0;
+    {
+      _gst_reset_bytecode_counter ();
+      _gst_primitives_executed = _gst_self_returns =
+	_gst_inst_var_returns = _gst_literal_returns =
+	_gst_sample_counter = 0;
+    }
 
   if (!IS_NIL (methodOOP))
     {
@@ -580,9 +660,17 @@ _gst_execute_statements (OOP receiverOOP,
 
       /* send a message to NIL, which will find this synthetic method
          definition in Object and execute it */
+      level = _gst_precomp_suspend ();
       resultOOP = _gst_nvmsg_send (receiverOOP, methodOOP, NULL, 0);
+      _gst_precomp_resume (level);
       INC_ADD_OOP (resultOOP);
 
+      /* A doit that moves the parser to a method list is a
+	 #methodsFor:, and the methods are recorded on their own.  */
+      if (!_gst_current_parser
+	  || _gst_current_parser->state != PARSE_METHOD_LIST)
+	_gst_precomp_doit (receiverOOP, methodOOP);
+
       endTime = _gst_get_milli_time ();
 #ifdef HAVE_GETRUSAGE
       getrusage (RUSAGE_SELF, &endRusage);
@@ -676,6 +764,160 @@ _gst_execute_statements (OOP receiverOOP,
   _gst_last_returned_value = resultOOP;
   return (_gst_last_returned_value);
 }
+
+
+int
+doit_cache_index (const char *source,
+		  size_t len,
+		  OOP classOOP,
+		  OOP namespaceOOP)
+{
+  uintptr_t hash = _gst_hash_string (source, len);
+  hash ^= scramble (OOP_INDEX (classOOP) ^ (OOP_INDEX (namespaceOOP) << 8));
+  return (hash & (DOIT_CACHE_SIZE - 1));
+}
+
+mst_Boolean
+is_doit_valid (OOP codeOOP,
+	       mst_Boolean chunk,
+	       OOP classOOP,
+	       OOP namespaceOOP)
+{
+  pool_list pools;
+  mst_Boolean valid;
+
+  pools = _gst_make_pool_list (classOOP, namespaceOOP, chunk);
+  valid = are_doit_bindings_valid (codeOOP, pools);
+  _gst_free_pool_list (pools);
+  return (valid);
+}
+
+mst_Boolean
+are_doit_bindings_valid (OOP codeOOP,
+			 pool_list pools)
+{
+  gst_object literals;
+  OOP literalsOOP, oop, environmentOOP, assocOOP;
+  gst_variable_binding binding;
+  int i, n;
+
+  /* CompiledMethod and CompiledBlock keep the literals at the same
+     offset.  */
+  literalsOOP = ((gst_compiled_method) OOP_TO_OBJ (codeOOP))->literals;
+  if (IS_NIL (literalsOOP))
+    return (true);
+
+  literals = OOP_TO_OBJ (literalsOOP);
+  n = NUM_OOPS (literals);
+  for (i = 0; i < n; i++)
+    {
+      oop = literals->data[i];
+      if (!IS_OOP (oop))
+	continue;
+
+      if (OOP_CLASS (oop) == _gst_block_closure_class)
+	oop = ((gst_block_closure) OOP_TO_OBJ (oop))->block;
+
+      if (OOP_CLASS (oop) == _gst_compiled_block_class)
+	{
+	  if (((gst_compiled_block) OOP_TO_OBJ (oop))->literals != literalsOOP
+	      && !are_doit_bindings_valid (oop, pools))
+	    return (false);
+	}
+
+      /* These refer to the temporaries of a single evaluation.  */
+      else if (OOP_CLASS (oop) == _gst_deferred_variable_binding_class)
+	return (false);
+
+      else if (OOP_CLASS (oop) == _gst_variable_binding_class)
+	{
+	  /* Check that the variable was not removed...  */
+	  binding = (gst_variable_binding) OOP_TO_OBJ (oop);
+	  environmentOOP = binding->environment;
+	  if (!IS_OOP (environmentOOP)
+	      || !is_a_kind_of (OOP_CLASS (environmentOOP),
+				_gst_dictionary_class)
+	      || dictionary_association_at (environmentOOP,
+					    binding->key) != oop)
+	    return (false);
+
+	  /* ... and that a class pool, shared pool or namespace that
+	     comes first in the lookup did not define a variable with
+	     the same name.  */
+	  assocOOP = _gst_pool_list_association_at (pools, binding->key);
+	  if (!IS_NIL (assocOOP) && assocOOP != oop)
+	    return (false);
+	}
+    }
+
+  return (true);
+}
+
+OOP
+_gst_lookup_doit (const char *source,
+		  size_t len,
+		  mst_Boolean chunk,
+		  OOP classOOP,
+		  OOP namespaceOOP)
+{
+  doit_cache_entry *entry;
+
+  entry = &doit_cache[doit_cache_index (source, len, classOOP, namespaceOOP)];
+  if (!entry->source
+      || entry->len != len
+      || entry->chunk != chunk
+      || entry->classOOP != classOOP
+      || entry->namespaceOOP != namespaceOOP
+      || memcmp (entry->source, source, len) != 0)
+    return (_gst_nil_oop);
+
+  /* A class whose shape changed has a new array of instance variable
+     names, and the doit might access the wrong variables.  Methods
+     that the doit sends are looked up anyway at run time.  */
+  if (entry->instVarsOOP != _gst_instance_variable_array (classOOP)
+      || !is_doit_valid (entry->methodOOP, chunk, classOOP, namespaceOOP))
+    return (_gst_nil_oop);
+
+  return (entry->methodOOP);
+}
+
+void
+_gst_cache_doit (const char *source,
+		 size_t len,
+		 mst_Boolean chunk,
+		 OOP classOOP,
+		 OOP namespaceOOP,
+		 OOP methodOOP)
+{
+  doit_cache_entry *entry;
+
+  if (!is_doit_valid (methodOOP, chunk, classOOP, namespaceOOP))
+    return;
+
+  entry = &doit_cache[doit_cache_index (source, len, classOOP, namespaceOOP)];
+  if (entry->source)
+    {
+      xfree (entry->source);
+      _gst_unregister_oop (entry->classOOP);
+      _gst_unregister_oop (entry->instVarsOOP);
+      _gst_unregister_oop (entry->namespaceOOP);
+      _gst_unregister_oop (entry->methodOOP);
+    }
+
+  entry->source = xmalloc (len + 1);
+  memcpy (entry->source, source, len);
+  entry->source[len] = '\0';
+  entry->len = len;
+  entry->chunk = chunk;
+  entry->classOOP = classOOP;
+  entry->instVarsOOP = _gst_instance_variable_array (classOOP);
+  entry->namespaceOOP = namespaceOOP;
+  entry->methodOOP = methodOOP;
+  _gst_register_oop (entry->classOOP);
+  _gst_register_oop (entry->instVarsOOP);
+  _gst_register_oop (entry->namespaceOOP);
+  _gst_register_oop (entry->methodOOP);
+}
 
 
 
@@ -695,7 +937,12 @@ _gst_compile_method (tree_node method,
   int stack_depth;
   inc_ptr incPtr;
   gst_compiled_method compiledMethod;
+  int level;
 
+  /* Code that runs while compiling, such as compile-time constants
+     and pragma handlers, is not part of a precompiled package: only
+     the resulting method is.  */
+  level = _gst_precomp_suspend ();
   outer_method = _gst_curr_method;
   outer_state = _gst_compiler_state;
   _gst_curr_method = method;
@@ -853,6 +1100,10 @@ _gst_compile_method (tree_node method,
   _gst_compiler_state = outer_state;
 
   INC_RESTORE_POINTER (incPtr);
+  _gst_precomp_resume (level);
+  if (install && !IS_NIL (methodOOP) && !_gst_had_error)
+    _gst_precomp_method (method->v_method.currentClass, methodOOP);
+
   return (methodOOP);
 }
 
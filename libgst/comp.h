@@ -287,6 +287,39 @@ extern OOP _gst_execute_statements (OOP receiverOOP,
 				    mst_Boolean quiet)
   ATTRIBUTE_HIDDEN;
 
+/* Execute the doit METHODOOP with RECEIVEROOP as the receiver, like
+   _gst_execute_statements does after compiling it, and answer the
+   result.  */
+extern OOP _gst_execute_doit (OOP receiverOOP,
+			      OOP methodOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Answer the doit that was compiled from the LEN bytes at SOURCE for
+   instances of CLASSOOP, with NAMESPACEOOP as the current namespace,
+   or nil if it is not in the doit cache or the variables it refers to
+   were redefined since.  CHUNK is true for code that is parsed like a
+   file-in (gst_eval_code), false for code that is compiled as the
+   body of a method (Behavior>>#evaluate:).  */
+extern OOP _gst_lookup_doit (const char *source,
+			     size_t len,
+			     mst_Boolean chunk,
+			     OOP classOOP,
+			     OOP namespaceOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Store METHODOOP in the doit cache, replacing any doit with the same
+   index, as the doit compiled from the LEN bytes at SOURCE for
+   instances of CLASSOOP in NAMESPACEOOP.  Nothing is stored if
+   METHODOOP refers to variables that the parser declared on the
+   fly.  */
+extern void _gst_cache_doit (const char *source,
+			     size_t len,
+			     mst_Boolean chunk,
+			     OOP classOOP,
+			     OOP namespaceOOP,
+			     OOP methodOOP)
+  ATTRIBUTE_HIDDEN;
+
 /* This routine does a very interesting thing.  It installs the inital
    method, which is the primitive for "methodsFor:".  It does this by
    creating a string that contains the method definition and then
@@ -74,6 +74,24 @@ typedef struct class_definition
 }
 class_definition;
 
+/* FastSet and FastDictionary look at a group of control bytes at a
+   time.  With SSE2 a group is 16 bytes and a bit mask has one bit per
+   byte; otherwise it is 8 bytes, compared within a 64-bit word, and
+   the bit mask has the high bit of each byte.  The group must not be
+   larger than FAST_HASHED_CLONED.  */
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define GROUP_WIDTH		16
+#define GROUP_MASK_SHIFT	0
+typedef unsigned int group_mask;
+#else
+#define GROUP_WIDTH		8
+#define GROUP_MASK_SHIFT	3
+#define GROUP_LSBS		((uint64_t) 0x0101010101010101ULL)
+#define GROUP_MSBS		((uint64_t) 0x8080808080808080ULL)
+typedef uint64_t group_mask;
+#endif
+
 /* Primary class variables.  These variables hold the class objects for
    most of the builtin classes in the system */
 OOP _gst_abstract_namespace_class = NULL;
@@ -212,6 +230,59 @@ static ssize_t identity_dictionary_find_key (OOP identityDictionaryOOP,
 static size_t identity_dictionary_find_key_or_nil (OOP identityDictionaryOOP,
 						   OOP keyOOP);
 
+/* Answer whether ELEMENTOOP = KEYOOP, or -1 if this would require
+   sending #=.  The VM knows #= only for SmallIntegers, Symbols and
+   Strings.  */
+static int hashed_keys_equal (OOP elementOOP,
+			      OOP keyOOP);
+
+/* Store in *PHASH what KEYOOP would answer to #identityHash if
+   IDENTITY is true, to #hash otherwise.  Answer false if this would
+   require sending #hash, which is only avoided for SmallIntegers,
+   Symbols and Strings.  */
+static mst_Boolean hashed_key_hash (OOP keyOOP,
+				    mst_Boolean identity,
+				    uintptr_t *pHash);
+
+/* Answer COLLECTIONOOP, a FastSet or FastDictionary (if HASVALUES is
+   true), or NULL if it must be rehashed or if its control bytes, keys
+   and values do not have the expected classes and sizes.  Store the
+   number of slots in *PCAPACITY.  */
+static gst_fast_hashed_collection fast_hashed_check (OOP collectionOOP,
+						     mst_Boolean hasValues,
+						     size_t *pCapacity);
+
+/* Look for KEYOOP, whose scrambled hash is HASH, in COLLECTION, which
+   has CAPACITY slots.  Answer true and store in *PSLOT the 0-based
+   slot holding the key if found; otherwise, answer false and store
+   there the first empty slot after the key's home.  Answer -1 if this
+   would require sending #=.  */
+static int fast_hashed_probe (gst_fast_hashed_collection collection,
+			      size_t capacity,
+			      OOP keyOOP,
+			      uintptr_t hash,
+			      size_t *pSlot);
+
+/* Set to BYTE the control byte for SLOT in CTRL, which describes
+   CAPACITY slots, including the copy at the end of the array.  */
+static inline void fast_hashed_set_ctrl (gst_uchar *ctrl,
+					 size_t capacity,
+					 size_t slot,
+					 int byte);
+
+/* Answer a bit mask of the bytes among the group starting at CTRL
+   which are equal to BYTE.  */
+static inline group_mask group_match (const gst_uchar *ctrl,
+				      int byte);
+
+/* Answer a bit mask of the empty slots among the group starting at
+   CTRL.  */
+static inline group_mask group_match_empty (const gst_uchar *ctrl);
+
+/* Answer the position in the group of the first slot in MASK, which
+   must not be zero.  */
+static inline int group_mask_first (group_mask mask);
+
 /* assume the value is an integer already or key does not exist, increase the
    value by inc or set the value to inc */
 static int _gst_identity_dictionary_at_inc (OOP identityDictionaryOOP,
@@ -440,9 +511,10 @@ static const class_definition class_info[] = {
    "Link", "nextLink", NULL, NULL },
 
   {&_gst_process_class, &_gst_link_class,
-   GST_ISP_FIXED, true, 7,
+   GST_ISP_FIXED, true, 8,
    "Process",
-   "suspendedContext priority myList name environment interrupts interruptLock",
+   "suspendedContext priority myList name environment interrupts interruptLock "
+   "statistics",
    NULL, NULL },
 
   {&_gst_callin_process_class, &_gst_process_class,
@@ -782,14 +854,15 @@ init_proto_oops()
   /* Also finish the creation of the OOPs with reserved indices in
      oop.h */
 
-  /* the symbol table ...  */
-  numWords = OBJ_HEADER_SIZE_WORDS + SYMBOL_TABLE_SIZE;
+  /* the symbol table (a tally and two slots per bucket) ...  */
+  numWords = OBJ_HEADER_SIZE_WORDS + 1 + SYMBOL_TABLE_SIZE * 2;
   symbolTable = _gst_alloc_words (numWords);
   SET_OOP_OBJECT (_gst_symbol_table, symbolTable);
 
   symbolTable->objClass = _gst_array_class;
   nil_fill (symbolTable->data,
 	    numWords - OBJ_HEADER_SIZE_WORDS);
+  symbolTable->data[0] = FROM_INT (0);
 
   /* 5 is the # of fixed instvars in gst_namespace */
   numWords = OBJ_HEADER_SIZE_WORDS + INITIAL_SMALLTALK_SIZE + 5;
@@ -1723,6 +1796,398 @@ identity_dictionary_find_key_or_nil (OOP identityDictionaryOOP,
   abort ();
 }
 
+int
+hashed_keys_equal (OOP elementOOP,
+		   OOP keyOOP)
+{
+  OOP elementClass, keyClass;
+  size_t len;
+
+  if (elementOOP == keyOOP)
+    return (true);
+
+  /* SmallIntegers are only equal to other numbers, which need
+     coercion, and Symbols are equal only to themselves.  Distinct
+     instances of these classes, and everything else compared to them,
+     are different.  Strings are equal if they have the same bytes.  */
+  elementClass = OOP_INT_CLASS (elementOOP);
+  keyClass = OOP_INT_CLASS (keyOOP);
+  if (elementClass != _gst_small_integer_class
+      && elementClass != _gst_symbol_class
+      && elementClass != _gst_string_class)
+    return (-1);
+
+  if (keyClass != _gst_small_integer_class
+      && keyClass != _gst_symbol_class
+      && keyClass != _gst_string_class)
+    return (-1);
+
+  if (elementClass != _gst_string_class || keyClass != _gst_string_class)
+    return (false);
+
+  len = NUM_INDEXABLE_FIELDS (elementOOP);
+  return (len == NUM_INDEXABLE_FIELDS (keyOOP)
+	  && !memcmp (STRING_OOP_CHARS (elementOOP),
+		      STRING_OOP_CHARS (keyOOP), len));
+}
+
+mst_Boolean
+hashed_key_hash (OOP keyOOP,
+		 mst_Boolean identity,
+		 uintptr_t *pHash)
+{
+  OOP keyClass;
+
+  if (IS_INT (keyOOP))
+    *pHash = TO_INT (keyOOP);
+  else if (identity)
+    *pHash = OOP_INDEX (keyOOP);
+  else
+    {
+      /* Compute the same hash as #hash would answer.  */
+      keyClass = OOP_CLASS (keyOOP);
+      if (keyClass == _gst_symbol_class)
+	*pHash = OOP_INDEX (keyOOP);
+      else if (keyClass == _gst_string_class)
+	*pHash = _gst_hash_string ((char *) STRING_OOP_CHARS (keyOOP),
+				   NUM_INDEXABLE_FIELDS (keyOOP));
+      else
+	return (false);
+    }
+
+  return (true);
+}
+
+size_t
+_gst_find_hashed_index (OOP collectionOOP,
+			OOP keyOOP,
+			hashed_layout layout,
+			mst_Boolean identity)
+{
+  gst_object collection;
+  OOP elementOOP;
+  size_t index, count, numSlots, numFixedFields, stride;
+  uintptr_t hash;
+  int equal;
+
+  if (OOP_NEEDS_REHASH (collectionOOP)
+      || !hashed_key_hash (keyOOP, identity, &hash))
+    return (0);
+
+  collection = OOP_TO_OBJ (collectionOOP);
+  numFixedFields = OOP_FIXED_FIELDS (collectionOOP);
+  stride = (layout == HASHED_KEYS_AND_VALUES) ? 2 : 1;
+  numSlots = (NUM_WORDS (collection) - numFixedFields) / stride;
+  if UNCOMMON (numSlots == 0)
+    return (0);
+
+  index = scramble (hash);
+  for (count = numSlots; count; count--, index++)
+    {
+      index &= numSlots - 1;
+      elementOOP = collection->data[numFixedFields + index * stride];
+      if (IS_NIL (elementOOP))
+	return (index + 1);
+
+      if (layout == HASHED_ASSOCIATIONS)
+	elementOOP = ((gst_association) OOP_TO_OBJ (elementOOP))->key;
+
+      if (identity)
+	equal = (elementOOP == keyOOP);
+      else
+	equal = hashed_keys_equal (elementOOP, keyOOP);
+
+      if (equal == -1)
+	return (0);
+      if (equal)
+	return (index + 1);
+    }
+
+  /* The table is full, which should never happen.  Let Smalltalk
+     loop.  */
+  return (0);
+}
+
+#ifdef __SSE2__
+group_mask
+group_match (const gst_uchar *ctrl,
+	     int byte)
+{
+  __m128i group = _mm_loadu_si128 ((const __m128i *) ctrl);
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (group, _mm_set1_epi8 (byte)));
+}
+
+group_mask
+group_match_empty (const gst_uchar *ctrl)
+{
+  /* Only empty slots have the high bit set.  */
+  __m128i group = _mm_loadu_si128 ((const __m128i *) ctrl);
+  return _mm_movemask_epi8 (group);
+}
+
+#else
+/* Load the group starting at CTRL with the first byte in the least
+   significant position, whatever the endianness.  */
+static inline uint64_t
+group_load (const gst_uchar *ctrl)
+{
+  uint64_t group = 0;
+  int i;
+
+  for (i = GROUP_WIDTH; --i >= 0; )
+    group = (group << 8) | ctrl[i];
+
+  return (group);
+}
+
+group_mask
+group_match (const gst_uchar *ctrl,
+	     int byte)
+{
+  /* Look for zero bytes after XORing with BYTE.  This can also
+     report a full slot just after a real match; probing checks the
+     key anyway, so that is harmless.  */
+  uint64_t group = group_load (ctrl) ^ (GROUP_LSBS * byte);
+  return ((group - GROUP_LSBS) & ~group & GROUP_MSBS);
+}
+
+group_mask
+group_match_empty (const gst_uchar *ctrl)
+{
+  return (group_load (ctrl) & GROUP_MSBS);
+}
+#endif
+
+int
+group_mask_first (group_mask mask)
+{
+#if GNUC_PREREQ (3, 4)
+  return (__builtin_ctzll (mask) >> GROUP_MASK_SHIFT);
+#else
+  int i;
+  for (i = 0; !(mask & 1); mask >>= 1)
+    i++;
+
+  return (i >> GROUP_MASK_SHIFT);
+#endif
+}
+
+void
+fast_hashed_set_ctrl (gst_uchar *ctrl,
+		      size_t capacity,
+		      size_t slot,
+		      int byte)
+{
+  ctrl[slot] = byte;
+  if (slot < FAST_HASHED_CLONED)
+    ctrl[capacity + slot] = byte;
+}
+
+gst_fast_hashed_collection
+fast_hashed_check (OOP collectionOOP,
+		   mst_Boolean hasValues,
+		   size_t *pCapacity)
+{
+  gst_fast_hashed_collection collection;
+  size_t capacity;
+
+  if UNCOMMON (OOP_FIXED_FIELDS (collectionOOP) < (hasValues ? 4 : 3)
+	       || OOP_NEEDS_REHASH (collectionOOP))
+    return (NULL);
+
+  collection = (gst_fast_hashed_collection) OOP_TO_OBJ (collectionOOP);
+  if UNCOMMON (!IS_INT (collection->tally)
+	       || OOP_INT_CLASS (collection->keys) != _gst_array_class
+	       || OOP_INT_CLASS (collection->ctrl) != _gst_byte_array_class)
+    return (NULL);
+
+  capacity = NUM_INDEXABLE_FIELDS (collection->keys);
+  if UNCOMMON (capacity < FAST_HASHED_CLONED
+	       || (capacity & (capacity - 1))
+	       || NUM_INDEXABLE_FIELDS (collection->ctrl)
+		  != capacity + FAST_HASHED_CLONED)
+    return (NULL);
+
+  /* FastDictionary has a parallel Array of values.  */
+  if (hasValues
+      && (OOP_INT_CLASS (collection->values) != _gst_array_class
+	  || NUM_INDEXABLE_FIELDS (collection->values) != capacity))
+    return (NULL);
+
+  *pCapacity = capacity;
+  return (collection);
+}
+
+int
+fast_hashed_probe (gst_fast_hashed_collection collection,
+		   size_t capacity,
+		   OOP keyOOP,
+		   uintptr_t hash,
+		   size_t *pSlot)
+{
+  gst_uchar *ctrl = (gst_uchar *) OOP_TO_OBJ (collection->ctrl)->data;
+  OOP *keys = OOP_TO_OBJ (collection->keys)->data;
+  size_t pos, slot, count;
+  group_mask match, empty;
+  int equal;
+
+  /* The low seven bits go in the control byte, the others choose the
+     home slot.  Keys are stored with linear probing, so all those
+     with the same home are found before the first empty slot.  */
+  pos = (hash >> 7) & (capacity - 1);
+  for (count = capacity; count; count -= GROUP_WIDTH)
+    {
+      match = group_match (ctrl + pos, hash & 0x7F);
+      empty = group_match_empty (ctrl + pos);
+      if (empty)
+	match &= (empty & -empty) - 1;
+
+      for (; match; match &= match - 1)
+	{
+	  slot = (pos + group_mask_first (match)) & (capacity - 1);
+	  equal = hashed_keys_equal (keys[slot], keyOOP);
+	  if UNCOMMON (equal == -1)
+	    return (-1);
+	  if (equal)
+	    {
+	      *pSlot = slot;
+	      return (true);
+	    }
+	}
+
+      if (empty)
+	{
+	  *pSlot = (pos + group_mask_first (empty)) & (capacity - 1);
+	  return (false);
+	}
+
+      pos = (pos + GROUP_WIDTH) & (capacity - 1);
+    }
+
+  /* The table is full, which should never happen.  Let Smalltalk
+     loop.  */
+  return (-1);
+}
+
+ssize_t
+_gst_fast_hashed_find (OOP collectionOOP,
+		       OOP keyOOP)
+{
+  gst_fast_hashed_collection collection;
+  size_t capacity, slot;
+  uintptr_t hash;
+  int found;
+
+  collection = fast_hashed_check (collectionOOP, false, &capacity);
+  if UNCOMMON (!collection || !hashed_key_hash (keyOOP, false, &hash))
+    return (0);
+
+  found = fast_hashed_probe (collection, capacity, keyOOP,
+			     scramble (hash), &slot);
+  if UNCOMMON (found == -1)
+    return (0);
+
+  return (found ? (ssize_t) slot + 1 : -(ssize_t) slot - 1);
+}
+
+size_t
+_gst_fast_hashed_at_put (OOP collectionOOP,
+			 OOP keyOOP,
+			 OOP valueOOP)
+{
+  gst_fast_hashed_collection collection;
+  size_t capacity, slot;
+  uintptr_t hash;
+  int found;
+
+  collection = fast_hashed_check (collectionOOP, valueOOP != NULL,
+				  &capacity);
+  if UNCOMMON (!collection || !hashed_key_hash (keyOOP, false, &hash))
+    return (0);
+
+  hash = scramble (hash);
+  found = fast_hashed_probe (collection, capacity, keyOOP, hash, &slot);
+  if UNCOMMON (found == -1)
+    return (0);
+
+  if (!found)
+    {
+      /* Let Smalltalk grow the collection if it is 7/8 full.  */
+      if UNCOMMON (TO_INT (collection->tally) >= capacity - capacity / 8)
+	return (0);
+
+      fast_hashed_set_ctrl ((gst_uchar *) OOP_TO_OBJ (collection->ctrl)->data,
+			    capacity, slot, hash & 0x7F);
+      OOP_TO_OBJ (collection->keys)->data[slot] = keyOOP;
+      collection->tally = INCR_INT (collection->tally);
+    }
+
+  if (valueOOP)
+    OOP_TO_OBJ (collection->values)->data[slot] = valueOOP;
+
+  return (slot + 1);
+}
+
+mst_Boolean
+_gst_fast_hashed_remove_index (OOP collectionOOP,
+			       size_t index,
+			       mst_Boolean hasValues)
+{
+  gst_fast_hashed_collection collection;
+  gst_uchar *ctrl;
+  OOP *keys, *values;
+  size_t capacity, hole, slot, home;
+  uintptr_t hash;
+
+  collection = fast_hashed_check (collectionOOP, hasValues, &capacity);
+  if UNCOMMON (!collection || index < 1 || index > capacity)
+    return (false);
+
+  ctrl = (gst_uchar *) OOP_TO_OBJ (collection->ctrl)->data;
+  keys = OOP_TO_OBJ (collection->keys)->data;
+  values = hasValues ? OOP_TO_OBJ (collection->values)->data : NULL;
+
+  hole = index - 1;
+  if UNCOMMON (ctrl[hole] == FAST_HASHED_EMPTY)
+    return (false);
+
+  /* Check that the home of every key in the cluster can be computed
+     before changing anything.  */
+  for (slot = (hole + 1) & (capacity - 1); ctrl[slot] != FAST_HASHED_EMPTY;
+       slot = (slot + 1) & (capacity - 1))
+    if (!hashed_key_hash (keys[slot], false, &hash))
+      return (false);
+
+  /* Move back each key that can be found from the hole, so that the
+     hole moves toward the end of the cluster and eventually becomes
+     an empty slot.  */
+  for (slot = (hole + 1) & (capacity - 1); ctrl[slot] != FAST_HASHED_EMPTY;
+       slot = (slot + 1) & (capacity - 1))
+    {
+      hashed_key_hash (keys[slot], false, &hash);
+      home = (scramble (hash) >> 7) & (capacity - 1);
+
+      /* Leave the key alone if its home is cyclically between the
+	 hole (exclusive) and its slot.  */
+      if (((slot - home) & (capacity - 1)) < ((slot - hole) & (capacity - 1)))
+	continue;
+
+      fast_hashed_set_ctrl (ctrl, capacity, hole, ctrl[slot]);
+      keys[hole] = keys[slot];
+      if (values)
+	values[hole] = values[slot];
+      hole = slot;
+    }
+
+  fast_hashed_set_ctrl (ctrl, capacity, hole, FAST_HASHED_EMPTY);
+  keys[hole] = _gst_nil_oop;
+  if (values)
+    values[hole] = _gst_nil_oop;
+
+  collection->tally = DECR_INT (collection->tally);
+  return (true);
+}
+
 OOP
 identity_dictionary_new (OOP classOOP, int size)
 {
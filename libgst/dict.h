@@ -131,6 +131,28 @@ typedef struct gst_identity_dictionary
 }
  *gst_identity_dictionary;
 
+/* FastSet and FastDictionary keep their keys (and values) in separate
+   Arrays, and one control byte per slot in CTRL.  */
+typedef struct gst_fast_hashed_collection
+{
+  OBJ_HEADER;
+  OOP tally;			/* really, an int */
+  OOP ctrl;			/* ByteArray of control bytes */
+  OOP keys;
+  OOP values;			/* only in FastDictionary */
+}
+ *gst_fast_hashed_collection;
+
+/* The control byte of an empty slot in a FastSet or FastDictionary.
+   A full slot holds the low seven bits of the scrambled hash of its
+   key.  */
+#define FAST_HASHED_EMPTY	0x80
+
+/* The number of control bytes that are copied after the end of the
+   control array, so that a group of slots can always be read without
+   wrapping around.  */
+#define FAST_HASHED_CLONED	16
+
 
 #define BEHAVIOR_HEADER \
   OBJ_HEADER; \
@@ -496,6 +518,59 @@ extern OOP _gst_dictionary_add (OOP dictionaryOOP,
 				OOP associationOOP) 
   ATTRIBUTE_HIDDEN;
 
+/* The layouts of the hash table of a HashedCollection, for
+   _gst_find_hashed_index.  */
+typedef enum
+{
+  HASHED_ELEMENTS,		/* one element per slot (Set) */
+  HASHED_KEYS_AND_VALUES,	/* key and value in two slots (LookupTable) */
+  HASHED_ASSOCIATIONS		/* one association per slot (Dictionary) */
+}
+hashed_layout;
+
+/* Look for KEYOOP in the hash table of COLLECTIONOOP, whose layout is
+   LAYOUT, comparing keys with #== if IDENTITY is true and with #=
+   otherwise; probing is the same as in the kernel's #findIndex:
+   methods.  Answer the 1-based index of the slot holding the key or,
+   if not found, of the empty slot where it would go.  Answer 0 if
+   the probe needs to send #hash or #=, which is only avoided for
+   SmallIntegers, Symbols and Strings, or if COLLECTIONOOP must be
+   rehashed first.  */
+extern size_t _gst_find_hashed_index (OOP collectionOOP,
+				      OOP keyOOP,
+				      hashed_layout layout,
+				      mst_Boolean identity)
+  ATTRIBUTE_HIDDEN;
+
+/* Look for KEYOOP in COLLECTIONOOP, a FastSet or FastDictionary.
+   Answer the 1-based index of the slot holding the key or, if not
+   found, minus the index of the empty slot where it would go.  Answer
+   0 if the probe needs to send #hash or #=, or if COLLECTIONOOP is
+   not well-formed or must be rehashed first.  */
+extern ssize_t _gst_fast_hashed_find (OOP collectionOOP,
+				      OOP keyOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Store KEYOOP in COLLECTIONOOP, a FastSet or FastDictionary, and
+   VALUEOOP in the corresponding value slot unless it is NULL (which
+   must be the case for a FastSet).  Answer
+   the 1-based index of the slot, or 0 if the probe needs to send
+   #hash or #=, or if a new key would need the collection to grow.  */
+extern size_t _gst_fast_hashed_at_put (OOP collectionOOP,
+				       OOP keyOOP,
+				       OOP valueOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Empty the slot at the 1-based INDEX of COLLECTIONOOP, a FastSet or
+   (if HASVALUES is true) a FastDictionary, moving back the keys that
+   follow it so that no tombstone is left.  Answer false, without
+   changing anything, if this needs to send #hash to one of those
+   keys.  */
+extern mst_Boolean _gst_fast_hashed_remove_index (OOP collectionOOP,
+						  size_t index,
+						  mst_Boolean hasValues)
+  ATTRIBUTE_HIDDEN;
+
 /* Look for the value associated to KEYOOP in IDENTITYDICTIONARYOOP
    and answer it or, if not found, _gst_nil_oop.  */
 extern OOP _gst_identity_dictionary_at (OOP identityDictionaryOOP,
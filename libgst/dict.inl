@@ -691,6 +691,7 @@ new_instance_with (OOP class_oop,
 
   p_instance->objClass = class_oop;
   (*p_oop)->flags |= (class_oop->flags & F_UNTRUSTED);
+  MAYBE_SAMPLE_ALLOCATION (*p_oop, alignedBytes);
 
   return p_instance;
 }
@@ -711,6 +712,7 @@ new_instance (OOP class_oop,
   p_instance = _gst_alloc_obj (numBytes, p_oop);
   p_instance->objClass = class_oop;
   (*p_oop)->flags |= (class_oop->flags & F_UNTRUSTED);
+  MAYBE_SAMPLE_ALLOCATION (*p_oop, numBytes);
 
   return p_instance;
 }
@@ -729,6 +731,7 @@ instantiate_numbytes (OOP class_oop,
   p_instance = _gst_alloc_obj (numBytes, p_oop);
   p_instance->objClass = class_oop;
   (*p_oop)->flags |= (class_oop->flags & F_UNTRUSTED);
+  MAYBE_SAMPLE_ALLOCATION (*p_oop, numBytes);
 
   n = instanceSpec >> ISP_NUMFIXEDFIELDS;
   if UNCOMMON (n == 0)
@@ -782,6 +785,7 @@ instantiate_with (OOP class_oop,
       p_instance = _gst_alloc_obj (numBytes, p_oop);
       p_instance->objClass = class_oop;
       (*p_oop)->flags |= (class_oop->flags & F_UNTRUSTED);
+      MAYBE_SAMPLE_ALLOCATION (*p_oop, numBytes);
       nil_fill (p_instance->data,
 	        (instanceSpec >> ISP_NUMFIXEDFIELDS) + numIndexFields);
     }
@@ -133,6 +133,14 @@ extern void _gst_pause (void);
 /* Wake up from a pause.  */
 extern void _gst_wakeup (void);
 
+/* Fork the virtual machine, answering the process id of the child in
+   the parent, 0 in the child and -1 on error.  If FD is not NULL, the
+   parent and the child are connected by a socket, and each gets its
+   end in *FD.  In the child, the timer is created again and the files
+   that the parent was polling are forgotten.  */
+extern int _gst_fork (int *fd)
+  ATTRIBUTE_HIDDEN;
+
 /* Initialize the event loop.  */
 void _gst_init_event_loop();
 
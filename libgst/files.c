@@ -223,6 +223,7 @@ static const char standard_files[] = {
   "ReadStream.st\0"
   "WriteStream.st\0"
   "RWStream.st\0"
+  "ChunkedStream.st\0"
   "UndefObject.st\0"
   "ProcSched.st\0"
   "ContextPart.st\0"
@@ -241,6 +242,7 @@ static const char standard_files[] = {
   "SymLink.st\0"
   "Security.st\0"
   "WeakObjects.st\0"
+  "FastHashed.st\0"
   "ObjMemory.st\0"
 
   /* More core classes */
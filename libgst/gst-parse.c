@@ -362,8 +362,14 @@ set_compilation_namespace (OOP namespaceOOP)
       if (oldNamespaceOOP != namespaceOOP)
         _gst_register_oop (namespaceOOP);
       if (namespaceOOP != _gst_current_namespace)
-        _gst_msg_sendf (NULL, "%v %o current: %o",
-                        _gst_namespace_class, namespaceOOP);
+        {
+          int level = _gst_precomp_send (_gst_namespace_class,
+                                         _gst_intern_string ("current:"),
+                                         &namespaceOOP, 1);
+          _gst_msg_sendf (NULL, "%v %o current: %o",
+                          _gst_namespace_class, namespaceOOP);
+          _gst_precomp_resume (level);
+        }
     }
 
   if (!IS_NIL (oldNamespaceOOP))
@@ -694,8 +700,17 @@ parse_scoped_definition (gst_parser *p, tree_node first_stmt)
 	  && (classOOP = parse_class (p, receiver)) != NULL)
 	{
 	  const char * name = expression->v_list.value->v_list.name;
+	  OOP args[2];
+	  int level;
+
+	  args[0] = _gst_intern_string (name);
+	  args[1] = p->current_namespace;
+	  level = _gst_precomp_send (classOOP,
+				     _gst_intern_string ("subclass:environment:"),
+				     args, 2);
 	  _gst_msg_sendf (&classOOP, "%o %o subclass: %S environment: %o",
                           classOOP, name, p->current_namespace);
+	  _gst_precomp_resume (level);
 	      
 	  if (IS_NIL (classOOP))
 	    _gst_had_error = true;
@@ -810,7 +825,9 @@ make_attribute (gst_parser *p, OOP classOOP, tree_node attribute_keywords)
        i++, keyword = keyword->v_list.next)
     {
       tree_node value = keyword->v_list.value;
+      int level = _gst_precomp_suspend ();
       OOP result = execute_doit (p, NULL, value, classOOP, false, true);
+      _gst_precomp_resume (level);
       if (!result)
         {
           _gst_had_error = true;
@@ -848,8 +865,11 @@ parse_and_send_attribute (gst_parser *p, OOP receiverOOP, mst_Boolean forClass)
           OOP argsOOP = MESSAGE_ARGS (messageOOP);
 	  int numArgs = NUM_OOPS (OOP_TO_OBJ (argsOOP));
           OOP *args = alloca(numArgs * sizeof (OOP));
+          int level;
           memcpy (args, OOP_TO_OBJ (argsOOP)->data, numArgs * sizeof (OOP));
+          level = _gst_precomp_send (receiverOOP, selectorOOP, args, numArgs);
           _gst_nvmsg_send (receiverOOP, selectorOOP, args, numArgs);
+          _gst_precomp_resume (level);
         }
     }
 
@@ -973,11 +993,16 @@ parse_class_definition (gst_parser *p, OOP classOOP, mst_Boolean extend)
 	      stmt = parse_required_expression (p);
 	      if (!_gst_had_error)
 		{
+		  int level = _gst_precomp_suspend ();
 	          stmt = _gst_make_statement_list (&stmt->location, stmt);
 	          result = execute_doit (p, NULL, stmt, the_class, false, true);
+		  _gst_precomp_resume (level);
 
 	          if (result)
-		    DICTIONARY_AT_PUT (class_var_dict, name, result);
+		    {
+		      _gst_precomp_class_variable (the_class, name, result);
+		      NAMESPACE_AT_PUT (class_var_dict, name, result);
+		    }
 		  else
 		    _gst_had_error = true;
 		}
@@ -1253,8 +1278,14 @@ parse_namespace (gst_parser *p, tree_node list)
   new_namespace = dictionary_at (current_namespace, name);
 
   if (new_namespace == _gst_nil_oop) 
-    _gst_msg_sendf (&current_namespace, "%o %o addSubspace: %o",
-		    current_namespace, name);
+    {
+      int level = _gst_precomp_send (current_namespace,
+				     _gst_intern_string ("addSubspace:"),
+				     &name, 1);
+      _gst_msg_sendf (&current_namespace, "%o %o addSubspace: %o",
+		      current_namespace, name);
+      _gst_precomp_resume (level);
+    }
 
   else if (_gst_object_is_kind_of (new_namespace, _gst_dictionary_class))
     current_namespace = new_namespace;
@@ -1274,6 +1305,8 @@ static void
 parse_instance_variables (gst_parser *p, OOP classOOP, mst_Boolean extend)
 {
   char *vars;
+  OOP varsOOP;
+  int level;
   Filament *fil = filnew (NULL, 0);
   
   if (extend)
@@ -1305,7 +1338,12 @@ parse_instance_variables (gst_parser *p, OOP classOOP, mst_Boolean extend)
     }
 
   vars = fildelete (fil);
+  varsOOP = _gst_intern_string (vars);
+  level = _gst_precomp_send (classOOP,
+			     _gst_intern_string ("instanceVariableNames:"),
+			     &varsOOP, 1);
   _gst_msg_sendf (NULL, "%v %o instanceVariableNames: %S", classOOP, vars);
+  _gst_precomp_resume (level);
   free (vars);
 }
 
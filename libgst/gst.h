@@ -222,7 +222,9 @@ enum gst_var_index {
   GST_GC_MESSAGE,
   GST_VERBOSITY,
   GST_MAKE_CORE_FILE,
-  GST_REGRESSION_TESTING
+  GST_REGRESSION_TESTING,
+  GST_PERF_MAP,
+  GST_LEX_AHEAD
 };
 
 enum gst_init_flags {
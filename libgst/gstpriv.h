@@ -77,6 +77,7 @@
 #include <dirent.h>
 #include <sys/time.h>
 #include <time.h>
+#include <locale.h>
 
 #ifdef HAVE_CRT_EXTERNS_H
 #include <crt_externs.h>
@@ -102,6 +103,10 @@
 #include <sys/mman.h>
 #endif
 
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 #ifdef HAVE_STDINT_H
 #include <stdint.h>
 #endif
@@ -135,6 +140,15 @@
 #define ATTRIBUTE_HIDDEN
 #endif
 
+/* Variables that are private to each thread.  Only used for the state
+   of the lexer, which can run in a separate thread (see lexahead.c)
+   only if the compiler supports them.  */
+#ifdef HAVE_THREAD_LOCAL
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
 /* At some point during the GCC 2.96 development the `pure' attribute
    for functions was introduced.  We don't want to use it
    unconditionally (although this would be possible) since it
@@ -266,7 +280,7 @@ extern char *strdup ();
    from the bottom.
 
    bit 0-3: reserved for distinguishing byte objects and saving their size.
-   bit 4-14: non-volatile bits (special kinds of objects).  Used up to 11.
+   bit 4-14: non-volatile bits (special kinds of objects).  Used up to 12.
    bit 15-30: volatile bits (GC/JIT-related).  Used up to 23.
    bit 31: unused to avoid signedness mess. */
 enum {
@@ -338,6 +352,11 @@ enum {
      garbage collect their contents, only the OOPs.  */
   F_LOADED = 0x800U,
 
+  /* Set for hashed collections whose hash table is not valid anymore,
+     for example after they were loaded from a file.  Lookups done by
+     the VM fail on them, so that Smalltalk rehashes them first.  */
+  F_REHASH = 0x1000U,
+
   /* Set to the number of bytes unused in an object with byte-sized
      instance variables.  Note that this field and the following one
      should be initialized only by INIT_UNALIGNED_OBJECT (not really 
@@ -367,6 +386,17 @@ enum {
   (((oop)->flags &= ~F_READONLY), \
    ((oop)->flags |= (ro) ? F_READONLY : 0))
 
+/* Answer whether the hash table of a collection, OOP, must be rebuilt
+   before looking up a key.  */
+#define OOP_NEEDS_REHASH(oop) \
+  (((oop)->flags & F_REHASH) != 0)
+
+/* Set whether the hash table of a collection, OOP, must be rebuilt
+   before looking up a key.  */
+#define MAKE_OOP_NEEDS_REHASH(oop, rehash) \
+  (((oop)->flags &= ~F_REHASH), \
+   ((oop)->flags |= (rehash) ? F_REHASH : 0))
+
 #ifdef ENABLE_SECURITY
 
 /* Answer whether an object, OOP, is untrusted.  */
@@ -592,6 +622,7 @@ extern OOP _gst_nil_oop
 #include "dict.h"
 #include "heap.h"
 #include "lex.h"
+#include "lexahead.h"
 #include "tree.h"
 #include "sym.h"
 #include "gst-parse.h"
@@ -609,6 +640,7 @@ extern OOP _gst_nil_oop
 #include "mpz.h"
 #include "print.h"
 #include "security.h"
+#include "precomp.h"
 #include "real.h"
 #include "sockets.h"
 
@@ -71,6 +71,7 @@ typedef struct string_stream
 {
   char *strBase;		/* base of asciz string */
   const char *str;		/* pointer into asciz string */
+  const char *end;		/* pointer to the final NUL */
 }
 string_stream;
 
@@ -80,6 +81,7 @@ typedef struct unix_file_stream
   char *buf;
   const char *ptr;
   const char *end;
+  size_t mapSize;		/* nonzero if BUF maps the whole file */
 }
 unix_file_stream;
 
@@ -109,6 +111,11 @@ typedef struct input_stream
   const char *fileName;
   off_t fileOffset;
 
+  /* The thread scanning the stream, if any, and whether we already
+     tried to start it.  */
+  lex_ahead lexAhead;
+  mst_Boolean lexAheadChecked;
+
   union
   {
     unix_file_stream u_st_file;
@@ -127,6 +134,15 @@ typedef struct input_stream
 /* The internal interface used by _gst_next_char.  */
 static int my_getc (input_stream stream);
 
+/* Answer whether STREAM has all of its contents in memory, so that
+   it never needs to be refilled.  */
+static inline mst_Boolean is_complete (input_stream stream);
+
+/* Try to map the contents of the file open on FD into memory, and
+   if successful make the buffer of STREAM point to them.  */
+static void map_file (input_stream stream,
+		      int fd);
+
 /* Return the File object or a file name for the topmost stream in the stack
    if it is of type STREAM_FILE; nil otherwise.  */
 static OOP get_cur_file (void);
@@ -134,13 +150,21 @@ static OOP get_cur_file (void);
 /* Print a line indicator in front of an error message.  */
 static void line_stamp (int line);
 
+/* Start a thread that scans STREAM, if it is a long enough regular
+   file that has not been read yet.  */
+static lex_ahead start_lex_ahead (input_stream stream);
+
+/* Return the file descriptor of OOP if it is a FileDescriptor open for
+   reading on something other than a pipe, otherwise -1.  */
+static int file_descriptor_fd (OOP oop);
+
 /* Allocate and push a new stream of type TYPE on the stack; the new
    stream is then available through IN_STREAM.  */
 static input_stream push_new_stream (stream_type type);
 
 /* The topmost stream in the stack, and the head of the linked list
-   that implements the stack.  */
-static input_stream in_stream = NULL;
+   that implements the stack.  Each lexer thread has its own.  */
+static THREAD_LOCAL input_stream in_stream = NULL;
 
 /* Poll FD until it is available for input (or until it returns
    POLLHUP) and then perform a read system call.  */
@@ -150,6 +174,9 @@ static int poll_and_read (int fd, char *buf, int n);
 /* If true, readline is disabled.  */
 mst_Boolean _gst_no_tty = false;
 
+/* The number of errors reported so far.  */
+unsigned long _gst_error_count = 0;
+
 /* >= 1 if completions are enabled, < 1 if they are not.  Available
    for completeness even if Readline is not used.  */
 static int completions_enabled = 1;
@@ -218,6 +245,8 @@ _gst_pop_stream (mst_Boolean closeIt)
   stream = in_stream;
   in_stream = in_stream->prevStream;
   _gst_unregister_oop (stream->fileOOP);
+  if (stream->lexAhead)
+    _gst_stop_lex_ahead (stream->lexAhead);
 
   switch (stream->type)
     {
@@ -234,7 +263,12 @@ _gst_pop_stream (mst_Boolean closeIt)
       break;
 
     case STREAM_FILE:
-      xfree (stream->st_file.buf);
+#ifndef WIN32
+      if (stream->st_file.mapSize)
+	munmap (stream->st_file.buf, stream->st_file.mapSize);
+      else
+#endif
+	xfree (stream->st_file.buf);
       if (closeIt)
         close (stream->st_file.fd);
       break;
@@ -251,11 +285,71 @@ _gst_push_unix_file (int fd,
 
   newStream = push_new_stream (STREAM_FILE);
   newStream->st_file.fd = fd;
-  newStream->st_file.buf = xmalloc (1024);
-  newStream->st_file.ptr = newStream->st_file.buf;
-  newStream->st_file.end = newStream->st_file.buf;
   newStream->fileName = fileName;
   newStream->fileOffset = lseek (fd, 0, SEEK_CUR);
+
+  /* Do not map stdin, whose position must advance as it is read.  */
+  newStream->st_file.mapSize = 0;
+  if (strcmp (fileName, "stdin") != 0)
+    map_file (newStream, fd);
+
+  if (!newStream->st_file.mapSize)
+    {
+      newStream->st_file.buf = xmalloc (1024);
+      newStream->st_file.ptr = newStream->st_file.buf;
+      newStream->st_file.end = newStream->st_file.buf;
+    }
+}
+
+void
+map_file (input_stream stream,
+	  int fd)
+{
+#ifndef WIN32
+  struct stat st;
+  char *buf;
+
+  if (stream->fileOffset == -1
+      || fstat (fd, &st) == -1
+      || !S_ISREG (st.st_mode)
+      || st.st_size == 0
+      || st.st_size < stream->fileOffset
+      || st.st_size != (size_t) st.st_size)
+    return;
+
+  buf = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (buf == (PTR) -1)
+    return;
+
+  /* _gst_get_location adds the position in the buffer to the file
+     offset, and the buffer starts at the beginning of the file.  */
+  stream->st_file.buf = buf;
+  stream->st_file.ptr = buf + stream->fileOffset;
+  stream->st_file.end = buf + st.st_size;
+  stream->st_file.mapSize = st.st_size;
+  stream->fileOffset = 0;
+#endif
+}
+
+void
+_gst_push_buffer (char *buf,
+		  size_t size,
+		  int line,
+		  int column,
+		  off_t offset)
+{
+  input_stream newStream;
+
+  /* This is a file stream whose contents were already read.  */
+  newStream = push_new_stream (STREAM_FILE);
+  newStream->st_file.fd = -1;
+  newStream->st_file.buf = buf;
+  newStream->st_file.ptr = buf;
+  newStream->st_file.end = buf + size;
+  newStream->st_file.mapSize = 0;
+  newStream->line = line;
+  newStream->column = column;
+  newStream->fileOffset = offset;
 }
 
 void
@@ -282,6 +376,7 @@ _gst_push_smalltalk_string (OOP stringOOP)
 
   newStream->st_str.strBase = (char *) _gst_to_cstring (stringOOP);
   newStream->st_str.str = newStream->st_str.strBase;
+  newStream->st_str.end = strchr (newStream->st_str.str, '\0');
   newStream->fileName = "a Smalltalk string";
 }
 
@@ -294,6 +389,7 @@ _gst_push_cstring (const char *string)
 
   newStream->st_str.strBase = xstrdup (string);
   newStream->st_str.str = newStream->st_str.strBase;
+  newStream->st_str.end = strchr (newStream->st_str.str, '\0');
   newStream->fileName = "a C string";
 }
 
@@ -338,6 +434,8 @@ push_new_stream (stream_type type)
   newStream->fileName = NULL;
   newStream->prompt = NULL;
   newStream->fileOOP = _gst_nil_oop;
+  newStream->lexAhead = NULL;
+  newStream->lexAheadChecked = false;
   newStream->prevStream = in_stream;
   in_stream = newStream;
   return (newStream);
@@ -422,7 +520,8 @@ my_getc (input_stream stream)
 	}
 
       /* Refill the buffer...  */
-      if (stream->st_file.ptr == stream->st_file.end)
+      if (stream->st_file.ptr == stream->st_file.end
+	  && !is_complete (stream))
 	{
 	  int n = poll_and_read (stream->st_file.fd, stream->st_file.buf, 1024);
 	  if (n < 0)
@@ -462,12 +561,190 @@ my_getc (input_stream stream)
 }
 
 
+mst_Boolean
+is_complete (input_stream stream)
+{
+  switch (stream->type)
+    {
+    case STREAM_STRING:
+      return (true);
+
+    case STREAM_FILE:
+      return (stream->st_file.fd == -1 || stream->st_file.mapSize);
+
+    default:
+      return (false);
+    }
+}
+
+const char *
+_gst_get_cur_stream_buffer (const char **end)
+{
+  if (!in_stream
+      || in_stream->prompt
+      || in_stream->pushedBackCount > 0)
+    return (NULL);
+
+  switch (in_stream->type)
+    {
+    case STREAM_STRING:
+      *end = in_stream->st_str.end;
+      return (in_stream->st_str.str);
+
+    case STREAM_FILE:
+    case STREAM_OOP:
+      /* This is just the part that was read so far, unless the file
+	 was mapped.  */
+      *end = in_stream->st_oop.end;
+      return (in_stream->st_oop.ptr);
+
+    default:
+      /* Readline reads a line at a time and must see every newline.  */
+      return (NULL);
+    }
+}
+
+void
+_gst_advance_cur_stream (const char *ptr)
+{
+  const char *p, *nl;
+
+  switch (in_stream->type)
+    {
+    case STREAM_STRING:
+      p = in_stream->st_str.str;
+      in_stream->st_str.str = ptr;
+      break;
+
+    default:
+      p = in_stream->st_oop.ptr;
+      in_stream->st_oop.ptr = (char *) ptr;
+      break;
+    }
+
+  /* Keep the line and column up to date, as _gst_next_char does.  */
+  while ((nl = memchr (p, '\n', ptr - p)))
+    {
+      in_stream->line++;
+      in_stream->column = 0;
+      p = nl + 1;
+    }
+
+  in_stream->column += ptr - p;
+}
+
 mst_Boolean
 _gst_get_cur_stream_prompt (void)
 {
   return in_stream && in_stream->prompt;
 }
 
+lex_ahead
+_gst_get_cur_stream_lex_ahead (void)
+{
+  if (!in_stream)
+    return (NULL);
+
+  if (!in_stream->lexAheadChecked)
+    {
+      in_stream->lexAheadChecked = true;
+      in_stream->lexAhead = start_lex_ahead (in_stream);
+    }
+
+  return (in_stream->lexAhead);
+}
+
+lex_ahead
+start_lex_ahead (input_stream stream)
+{
+#ifdef ENABLE_LEX_AHEAD
+  struct stat st;
+  char *buf;
+  size_t size, n;
+  ssize_t result;
+  off_t offset;
+  int fd;
+
+  /* Interactive streams are read a line at a time, and the lexer
+     threads already read from memory.  */
+  if (!_gst_lex_ahead || _gst_current_lex_ahead
+      || stream->prompt || stream->fileOffset == -1
+      || stream->pushedBackCount > 0)
+    return (NULL);
+
+  switch (stream->type)
+    {
+    case STREAM_FILE:
+      if ((stream->st_file.ptr != stream->st_file.end
+	   && !stream->st_file.mapSize)
+	  || strcmp (stream->fileName, "stdin") == 0)
+	return (NULL);
+
+      fd = stream->st_file.fd;
+      break;
+
+    case STREAM_OOP:
+      /* Used by FileDescriptor>>#fileIn.  The file is read with pread,
+	 so the Smalltalk object is left alone.  */
+      if (stream->st_oop.ptr != stream->st_oop.end
+	  || IS_NIL (stream->fileOOP))
+	return (NULL);
+
+      fd = file_descriptor_fd (stream->st_oop.oop);
+      break;
+
+    default:
+      return (NULL);
+    }
+
+  /* A mapped file is scanned from the mapping's current position.  */
+  offset = stream->fileOffset + (stream->st_oop.ptr - stream->st_oop.buf);
+  if (fd == -1
+      || fstat (fd, &st) == -1
+      || !S_ISREG (st.st_mode)
+      || st.st_size - offset < LEX_AHEAD_MIN_SIZE)
+    return (NULL);
+
+  size = st.st_size - offset;
+  buf = xmalloc (size);
+  for (n = 0; n < size; n += result)
+    {
+      do
+	result = pread (fd, buf + n, size - n, offset + n);
+      while (result == -1 && errno == EINTR);
+
+      if (result <= 0)
+	{
+	  xfree (buf);
+	  return (NULL);
+	}
+    }
+
+  return (_gst_start_lex_ahead (buf, size, stream->line, stream->column,
+				offset));
+#else
+  return (NULL);
+#endif
+}
+
+int
+file_descriptor_fd (OOP oop)
+{
+  gst_file_stream fileStream;
+
+  if (!IS_OOP (oop)
+      || !is_a_kind_of (OOP_CLASS (oop), _gst_file_descriptor_class))
+    return (-1);
+
+  fileStream = (gst_file_stream) OOP_TO_OBJ (oop);
+  if (!IS_INT (fileStream->fd)
+      || fileStream->access != FROM_INT (1)
+      || fileStream->isPipe == _gst_true_oop)
+    return (-1);
+
+  return (TO_INT (fileStream->fd));
+}
+
 stream_type
 _gst_get_cur_stream_type (void)
 {
@@ -540,7 +817,7 @@ _gst_get_source_string (off_t startPos, off_t endPos)
     result = _gst_counted_string_new (p + (startPos - in_stream->fileOffset),
 				      endPos - startPos);
 
-  if (in_stream->type != STREAM_STRING)
+  if (!is_complete (in_stream))
     {
       /* Copy back to the beginning of the buffer to save memory.  */
       size = in_stream->st_oop.end - in_stream->st_oop.ptr;
@@ -630,6 +907,7 @@ _gst_errorf_at (int line,
 
   va_start (ap, str);
 
+  _gst_error_count++;
   if (_gst_report_errors)
     fflush (stdout);
 
@@ -657,6 +935,16 @@ _gst_errorf (const char *str,
 
   va_start (ap, str);
 
+  /* Lexer threads leave it to the parser to report errors, so that
+     they are printed in order.  */
+  if (_gst_current_lex_ahead)
+    {
+      _gst_lex_ahead_error (_gst_current_lex_ahead, str, ap);
+      va_end (ap);
+      return;
+    }
+
+  _gst_error_count++;
   if (_gst_report_errors)
     fflush (stdout);
 
@@ -686,6 +974,10 @@ YYLTYPE
 _gst_get_location (void)
 {
   YYLTYPE loc;
+
+  if (in_stream->lexAhead)
+    return (_gst_lex_ahead_location (in_stream->lexAhead));
+
   loc.first_line = in_stream->line;
   loc.first_column = in_stream->column;
 
@@ -703,7 +995,9 @@ void
 line_stamp (int line)
 {
   if (line <= 0 && in_stream)
-    line = in_stream->line;
+    line = (in_stream->lexAhead
+	    ? _gst_lex_ahead_location (in_stream->lexAhead).first_line
+	    : in_stream->line);
 
   if (_gst_report_errors)
     {
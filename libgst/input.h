@@ -70,6 +70,12 @@ stream_type;
 extern mst_Boolean _gst_no_tty 
   ATTRIBUTE_HIDDEN;
 
+/* The number of errors reported by _gst_errorf and _gst_errorf_at,
+   which tells whether the compilation of some code was successful
+   even when the parser recovered from the errors.  */
+extern unsigned long _gst_error_count
+  ATTRIBUTE_HIDDEN;
+
 /* Pass file descriptor FD, printed as file name FILENAME, to the
    parser.  */
 extern void _gst_push_unix_file (int fd,
@@ -81,6 +87,16 @@ extern void _gst_push_unix_file (int fd,
 extern YYLTYPE _gst_get_location (void) 
   ATTRIBUTE_HIDDEN;
 
+/* Pass the SIZE bytes at BUF to the parser.  They start at byte
+   OFFSET of a file, on line LINE and column COLUMN.  BUF is freed
+   when the stream is popped.  */
+extern void _gst_push_buffer (char *buf,
+			      size_t size,
+			      int line,
+			      int column,
+			      off_t offset)
+  ATTRIBUTE_HIDDEN;
+
 /* Pass the OOP to the parser; it must respond to #nextHunk.  */
 extern void _gst_push_stream_oop (OOP oop) 
   ATTRIBUTE_HIDDEN;
@@ -164,11 +180,30 @@ extern void _gst_unread_char (int ic)
 extern int _gst_next_char (void) 
   ATTRIBUTE_HIDDEN;
 
+/* Return a pointer to the characters of the topmost stream that are
+   already in memory and were not read yet, and store in *END a pointer
+   past the last of them; return NULL for interactive streams and when
+   characters were pushed back.  The lexer scans the characters
+   directly, then consumes them with _gst_advance_cur_stream.  */
+extern const char *_gst_get_cur_stream_buffer (const char **end)
+  ATTRIBUTE_HIDDEN;
+
+/* Consume the characters of the topmost stream up to PTR, which must
+   be within the buffer returned by _gst_get_cur_stream_buffer.  */
+extern void _gst_advance_cur_stream (const char *ptr)
+  ATTRIBUTE_HIDDEN;
+
 /* Return whether the topmost stream is an interactive one.  */
 extern mst_Boolean _gst_get_cur_stream_prompt (void)
   ATTRIBUTE_PURE 
   ATTRIBUTE_HIDDEN;
 
+/* Return the thread that scans the topmost stream in the stack,
+   starting it the first time if the stream can be scanned in a
+   separate thread; NULL if the stream is scanned by _gst_yylex.  */
+extern lex_ahead _gst_get_cur_stream_lex_ahead (void)
+  ATTRIBUTE_HIDDEN;
+
 /* Return the type of the topmost stream in the stack.  */
 extern stream_type _gst_get_cur_stream_type (void)
   ATTRIBUTE_PURE 
@@ -527,6 +527,9 @@ monitor_byte_codes:
   if (async_queue_enabled)
     empty_async_queue ();
 
+  if UNCOMMON (time_to_sample)
+    take_profile_sample ();
+
   if UNCOMMON (time_to_preempt)
     ACTIVE_PROCESS_YIELD ();
 
@@ -419,6 +419,9 @@ _gst_interpret (OOP processOOP)
 	  (gst_method_context) OOP_TO_OBJ (_gst_this_context_oop);
         thisContext->native_ip = GET_NATIVE_IP (native_ip);
 
+        if UNCOMMON (time_to_sample)
+	  take_profile_sample ();
+
         if UNCOMMON (!IS_NIL (switch_to_process))
 	  {
 	    change_process_context (switch_to_process);
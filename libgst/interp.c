@@ -124,6 +124,19 @@ typedef struct interp_jmp_buf
 }
 interp_jmp_buf;
 
+/* The CPU accounting data for a Process, kept in a ByteArray that
+   the VM stores in the Process's statistics instance variable the
+   first time the Process is resumed.  */
+typedef struct process_statistics
+{
+  uint64_t bytecodes;		/* bytecodes executed */
+  uint64_t cpuTime;		/* nanoseconds spent as the active process */
+  uint64_t switches;		/* times the process was switched to */
+  uint64_t waitTime;		/* nanoseconds spent waiting on semaphores */
+  uint64_t waitStart;		/* start of the current wait, or 0 */
+}
+process_statistics;
+
 
 
 /* If this is true, for each byte code that is executed, we print on
@@ -253,10 +266,36 @@ const char *_gst_abort_execution = NULL;
 /* Set to non-nil if a process must preempt the current one.  */
 static OOP switch_to_process;
 
+/* Bit N is set if the list of ready processes at priority N might
+   not be empty.  Bits are set whenever a process is added to a list,
+   and cleared when a list is found to be empty, so that picking the
+   next process does not have to scan every priority.  */
+static unsigned int ready_priorities;
+
+/* The time and the value of _gst_bytecode_counter when the active
+   process was switched to.  */
+static uint64_t switch_time;
+static unsigned long switch_bytecodes;
+
 /* Set to true if it is time to switch process in a round-robin
    time-sharing fashion.  */
 static mst_Boolean time_to_preempt;
 
+/* The sampling profiler keeps its samples in a ring buffer of OOPs,
+   allocated when sampling is first started.  Each sample is a
+   SmallInteger N followed by the N CompiledMethods and CompiledBlocks
+   of the active contexts, innermost first.  PROFILE_HEAD and
+   PROFILE_TAIL count the OOPs that were written and drained; samples
+   that do not fit are counted in PROFILE_DROPPED.  */
+#define PROFILE_BUFFER_SIZE 65536
+#define PROFILE_MAX_DEPTH 256
+static OOP *profile_buffer;
+static size_t profile_head, profile_tail, profile_dropped;
+
+/* Set to true by the profiling timer; a sample is then taken at the
+   next sequence point.  */
+static mst_Boolean time_to_sample;
+
 /* Used to bail out of a C callout and back to the interpreter.  */
 static interp_jmp_buf *reentrancy_jmp_buf = NULL;
 
@@ -387,6 +426,15 @@ static void suspend_process (OOP processOOP);
 static mst_Boolean resume_process (OOP processOOP,
 				   mst_Boolean alwaysPreempt);
 
+/* Answer the CPU accounting data for PROCESSOOP, or NULL if it has
+   none yet.  The pointer is invalidated by garbage collections.  */
+static inline process_statistics *get_process_statistics (OOP processOOP);
+
+/* Add to PROCESSOOP's waiting time the time since it started waiting
+   on a semaphore, if it did, up to NOW.  */
+static inline void end_semaphore_wait (OOP processOOP,
+				       uint64_t now);
+
 /* Answer whether PROCESSOOP is ready to execute (neither terminating,
    nor suspended, nor waiting on a semaphore).  */
 static mst_Boolean is_process_ready (OOP processOOP) ATTRIBUTE_PURE;
@@ -514,12 +562,51 @@ static mst_Boolean unwind_to (OOP returnContextOOP);
    doing a local return.  */
 static mst_Boolean disable_non_unwind_contexts (OOP returnContextOOP);
 
+/* Answer the first method context, starting at contextOOP and going
+   up the chain of parent contexts until an execution environment,
+   whose method has an attribute with the selector selectorOOP.
+   Answer nil if there is none.  This is how exception handlers
+   are found, so it must not allocate anything.  */
+static OOP find_context_with_attribute (OOP contextOOP,
+					OOP selectorOOP);
+
+/* The most chunks that write_chunks passes to the system at once.
+   writev accepts no more than IOV_MAX buffers anyway, which is 1024
+   on most systems; callers retry with the chunks that are left.  */
+#define MAX_WRITE_CHUNKS 1024
+
+/* Write to FD the byte objects held by the Array ARRAYOOP, with a
+   single system call if possible.  Answer the number of bytes written,
+   -1 on error, -2 (with errno cleared) if ARRAYOOP is not an Array of
+   byte objects.  Used by the file and socket primitives.  */
+static ssize_t write_chunks (int fd,
+			     OOP arrayOOP);
+
 /* Called to preempt the current process after a specified amount
    of time has been spent in the GNU Smalltalk interpreter.  */
 #ifdef ENABLE_PREEMPTION
 static RETSIGTYPE preempt_smalltalk_process (int sig);
 #endif
 
+/* Called by the profiling timer to ask for a sample.  */
+static RETSIGTYPE sample_smalltalk_process (int sig);
+
+/* Take a sample every USEC microseconds of CPU time, or stop sampling
+   if USEC is zero.  */
+static void set_profile_sampling (int usec);
+
+/* Record the methods of the active contexts in the profiler's ring
+   buffer.  */
+static void take_profile_sample (void);
+
+/* Answer an Array with an Array for each sample in the profiler's
+   ring buffer, which is emptied.  */
+static OOP drain_profile_samples (void);
+
+/* Pass the OOPs in the profiler's ring buffer to FUNC, which marks
+   or copies them.  */
+static void scan_profile_samples (void (*func) (OOP *, OOP *));
+
 /* Push an execution state for process PROCESSOOP.  The process is
    used for two reasons: 1) it is suspended if there is a call-in
    while the execution state is on the top of the stack; 2) it is
@@ -548,6 +635,29 @@ static void stop_execution (void);
 #define GET_PROCESS_LISTS() \
   (((gst_processor_scheduler)OOP_TO_OBJ(_gst_processor_oop))->processLists)
 
+/* Remember that the list of ready processes at PRIORITY is not empty.  */
+#define MARK_READY_PRIORITY(priority) \
+  (ready_priorities |= 1U << (priority))
+
+/* Answer the highest priority whose bit is set in MASK, which must
+   not be zero.  */
+#if GNUC_PREREQ (3, 4)
+#define HIGHEST_PRIORITY(mask) \
+  ((int) (sizeof (unsigned int) * CHAR_BIT - 1) - __builtin_clz (mask))
+#else
+#define HIGHEST_PRIORITY(mask) highest_bit (mask)
+
+static inline int
+highest_bit (unsigned int mask)
+{
+  int bit = 0;
+  while (mask >>= 1)
+    bit++;
+
+  return (bit);
+}
+#endif
+
 /* Tell the interpreter that special actions are needed as soon as a
    sequence point is reached.  */
 #ifdef ENABLE_JIT_TRANSLATION
@@ -1273,6 +1383,85 @@ disable_non_unwind_contexts (OOP returnContextOOP)
   return (true);
 }
 
+OOP
+find_context_with_attribute (OOP contextOOP,
+			     OOP selectorOOP)
+{
+  gst_method_context context;
+  gst_method_info info;
+  OOP infoOOP;
+  int num_attributes, i;
+
+  while (!IS_NIL (contextOOP))
+    {
+      context = (gst_method_context) OOP_TO_OBJ (contextOOP);
+      if (CONTEXT_FLAGS (context) & MCF_IS_METHOD_CONTEXT)
+	{
+	  infoOOP = get_method_info (context->method);
+	  if COMMON (IS_OOP (infoOOP) && !IS_NIL (infoOOP))
+	    {
+	      info = (gst_method_info) OOP_TO_OBJ (infoOOP);
+	      num_attributes = NUM_INDEXABLE_FIELDS (infoOOP);
+	      for (i = 0; i < num_attributes; i++)
+		{
+		  OOP attrOOP = info->attributes[i];
+		  if (IS_OOP (attrOOP) && !IS_NIL (attrOOP)
+		      && ((gst_message) OOP_TO_OBJ (attrOOP))->selector
+			 == selectorOOP)
+		    return (contextOOP);
+		}
+	    }
+
+	  if (CONTEXT_FLAGS (context) & MCF_IS_EXECUTION_ENVIRONMENT)
+	    break;
+	}
+
+      contextOOP = context->parentContext;
+    }
+
+  return (_gst_nil_oop);
+}
+
+ssize_t
+write_chunks (int fd,
+	      OOP arrayOOP)
+{
+  PTR *buffers;
+  size_t *sizes;
+  int count, i;
+
+  if (IS_INT (arrayOOP) || OOP_CLASS (arrayOOP) != _gst_array_class)
+    goto bad;
+
+  count = NUM_INDEXABLE_FIELDS (arrayOOP);
+  if (count == 0)
+    return (0);
+
+  /* The buffers live on the stack.  */
+  if (count > MAX_WRITE_CHUNKS)
+    count = MAX_WRITE_CHUNKS;
+
+  buffers = alloca (count * sizeof (PTR));
+  sizes = alloca (count * sizeof (size_t));
+  for (i = 0; i < count; i++)
+    {
+      OOP chunkOOP = ARRAY_AT (arrayOOP, i + 1);
+      if (IS_INT (chunkOOP)
+	  || !IS_PLAIN_BYTES_SPEC (OOP_INSTANCE_SPEC (chunkOOP)))
+	goto bad;
+
+      buffers[i] = STRING_OOP_CHARS (chunkOOP);
+      sizes[i] = NUM_INDEXABLE_FIELDS (chunkOOP);
+    }
+
+  /* Nothing can be allocated from here on, so the pointers stay valid.  */
+  return (_gst_write_buffers (fd, buffers, sizes, count));
+
+ bad:
+  errno = 0;
+  return (-2);
+}
+
 
 OOP
 _gst_make_block_closure (OOP blockOOP)
@@ -1309,10 +1498,24 @@ change_process_context (OOP newProcess)
   OOP processOOP;
   gst_process process;
   gst_processor_scheduler processor;
+  process_statistics *statistics;
   mst_Boolean enable_async_queue;
+  uint64_t now;
 
   switch_to_process = _gst_nil_oop;
 
+  /* Give NEWPROCESS a place for its accounting data the first time it
+     runs.  Nothing has been saved yet, so the allocation is safe.  */
+  process = (gst_process) OOP_TO_OBJ (newProcess);
+  if (IS_NIL (process->statistics))
+    {
+      OOP statisticsOOP;
+      instantiate_with (_gst_byte_array_class, sizeof (process_statistics),
+			&statisticsOOP);
+      process = (gst_process) OOP_TO_OBJ (newProcess);
+      process->statistics = statisticsOOP;
+    }
+
   /* save old context information */
   if (!IS_NIL (_gst_this_context_oop))
     empty_context_stack ();
@@ -1330,6 +1533,24 @@ change_process_context (OOP newProcess)
       if (!IS_NIL (processOOP) && !is_process_terminating (processOOP))
         process->suspendedContext = _gst_this_context_oop;
 
+      /* Charge the time and the bytecodes since the last switch to the
+         process that is being suspended.  */
+      now = _gst_get_ns_time ();
+      statistics = get_process_statistics (processOOP);
+      if (statistics)
+	{
+	  statistics->cpuTime += now - switch_time;
+	  statistics->bytecodes += _gst_bytecode_counter - switch_bytecodes;
+	}
+
+      end_semaphore_wait (newProcess, now);
+      statistics = get_process_statistics (newProcess);
+      if (statistics)
+	statistics->switches++;
+
+      switch_time = now;
+      switch_bytecodes = _gst_bytecode_counter;
+
       processor->activeProcess = newProcess;
       process = (gst_process) OOP_TO_OBJ (newProcess);
       enable_async_queue = IS_NIL (process->interrupts)
@@ -1397,6 +1618,37 @@ get_scheduled_process (void)
   return (processor->activeProcess);
 }
 
+process_statistics *
+get_process_statistics (OOP processOOP)
+{
+  gst_process process;
+
+  if (IS_NIL (processOOP))
+    return (NULL);
+
+  process = (gst_process) OOP_TO_OBJ (processOOP);
+  if (!IS_CLASS (process->statistics, _gst_byte_array_class)
+      || NUM_INDEXABLE_FIELDS (process->statistics)
+	 < sizeof (process_statistics))
+    return (NULL);
+
+  return ((process_statistics *) OOP_TO_OBJ (process->statistics)->data);
+}
+
+void
+end_semaphore_wait (OOP processOOP,
+		    uint64_t now)
+{
+  process_statistics *statistics;
+
+  statistics = get_process_statistics (processOOP);
+  if (statistics && statistics->waitStart)
+    {
+      statistics->waitTime += now - statistics->waitStart;
+      statistics->waitStart = 0;
+    }
+}
+
 static void
 remove_process_from_list (OOP processOOP)
 {
@@ -1550,6 +1802,7 @@ _gst_sync_signal (OOP semaphoreOOP, mst_Boolean incr_if_empty)
 	}
 
       processOOP = remove_first_link (semaphoreOOP);
+      end_semaphore_wait (processOOP, _gst_get_ns_time ());
 
       /* If they terminated this process, well, try another */
     }
@@ -1695,6 +1948,7 @@ void
 sync_wait_process (OOP semaphoreOOP, OOP processOOP)
 {
   gst_semaphore sem;
+  process_statistics *statistics;
   mst_Boolean isActive;
 
   sem = (gst_semaphore) OOP_TO_OBJ (semaphoreOOP);
@@ -1716,6 +1970,9 @@ sync_wait_process (OOP semaphoreOOP, OOP processOOP)
       SET_STACKTOP (_gst_nil_oop);
       remove_process_from_list (processOOP);
       add_last_link (semaphoreOOP, processOOP);
+      statistics = get_process_statistics (processOOP);
+      if (statistics)
+	statistics->waitStart = _gst_get_ns_time ();
       if (isActive && IS_NIL (ACTIVE_PROCESS_YIELD ()))
         {
 	  printf ("No runnable process");
@@ -1816,6 +2073,7 @@ resume_process (OOP processOOP,
          Anyway, it must be the first in its priority queue - so don't
          put it to sleep.  */
       add_first_link (processList, processOOP);
+      MARK_READY_PRIORITY (priority);
     }
 
   return (true);
@@ -1840,6 +2098,7 @@ activate_process (OOP processOOP)
       processLists = GET_PROCESS_LISTS ();
       processList = ARRAY_AT (processLists, priority);
       add_first_link (processList, processOOP);
+      MARK_READY_PRIORITY (priority);
     }
 
   SET_EXCEPT_FLAG (true);
@@ -1856,6 +2115,105 @@ preempt_smalltalk_process (int sig)
 }
 #endif
 
+RETSIGTYPE
+sample_smalltalk_process (int sig)
+{
+  time_to_sample = true;
+  SET_EXCEPT_FLAG (true);
+}
+
+void
+set_profile_sampling (int usec)
+{
+  if (usec > 0 && !profile_buffer)
+    profile_buffer = (OOP *) xmalloc (PROFILE_BUFFER_SIZE * sizeof (OOP));
+
+  time_to_sample = false;
+  _gst_sigprof_every (usec, sample_smalltalk_process);
+}
+
+void
+take_profile_sample (void)
+{
+  OOP contextOOP;
+  gst_method_context context;
+  size_t n;
+
+  time_to_sample = false;
+  if (!profile_buffer)
+    return;
+
+  for (n = 0, contextOOP = _gst_this_context_oop;
+       n < PROFILE_MAX_DEPTH && !IS_NIL (contextOOP);
+       n++, contextOOP = context->parentContext)
+    context = (gst_method_context) OOP_TO_OBJ (contextOOP);
+
+  if (n + 1 > PROFILE_BUFFER_SIZE - (profile_head - profile_tail))
+    {
+      profile_dropped++;
+      return;
+    }
+
+  profile_buffer[profile_head++ % PROFILE_BUFFER_SIZE] = FROM_INT (n);
+  for (contextOOP = _gst_this_context_oop; n--;
+       contextOOP = context->parentContext)
+    {
+      context = (gst_method_context) OOP_TO_OBJ (contextOOP);
+      profile_buffer[profile_head++ % PROFILE_BUFFER_SIZE] = context->method;
+    }
+}
+
+OOP
+drain_profile_samples (void)
+{
+  OOP resultOOP, sampleOOP;
+  size_t pos, numSamples, n, i;
+  inc_ptr incPtr;
+
+  for (numSamples = 0, pos = profile_tail; pos != profile_head;
+       numSamples++, pos += n + 1)
+    n = TO_INT (profile_buffer[pos % PROFILE_BUFFER_SIZE]);
+
+  /* The samples stay in the buffer, and are thus reachable, until
+     they are copied into the Array.  */
+  incPtr = INC_SAVE_POINTER ();
+  instantiate_with (_gst_array_class, numSamples, &resultOOP);
+  INC_ADD_OOP (resultOOP);
+  for (i = 1; i <= numSamples; i++)
+    {
+      n = TO_INT (profile_buffer[profile_tail % PROFILE_BUFFER_SIZE]);
+      instantiate_with (_gst_array_class, n, &sampleOOP);
+      for (pos = 1; pos <= n; pos++)
+        ARRAY_AT_PUT (sampleOOP, pos,
+		      profile_buffer[(profile_tail + pos) % PROFILE_BUFFER_SIZE]);
+
+      ARRAY_AT_PUT (resultOOP, i, sampleOOP);
+      profile_tail += n + 1;
+    }
+
+  INC_RESTORE_POINTER (incPtr);
+  return resultOOP;
+}
+
+void
+scan_profile_samples (void (*func) (OOP *, OOP *))
+{
+  size_t first, last;
+
+  if (profile_head == profile_tail)
+    return;
+
+  first = profile_tail % PROFILE_BUFFER_SIZE;
+  last = profile_head % PROFILE_BUFFER_SIZE;
+  if (first < last)
+    func (&profile_buffer[first], &profile_buffer[last]);
+  else
+    {
+      func (&profile_buffer[first], &profile_buffer[PROFILE_BUFFER_SIZE]);
+      func (profile_buffer, &profile_buffer[last]);
+    }
+}
+
 mst_Boolean
 is_process_terminating (OOP processOOP)
 {
@@ -1897,6 +2255,7 @@ sleep_process (OOP processOOP)
 
   /* add process to end of priority queue */
   add_last_link (processList, processOOP);
+  MARK_READY_PRIORITY (priority);
 }
 
 
@@ -1905,6 +2264,7 @@ would_reschedule_process ()
 {
   OOP processLists, processListOOP;
   int priority, activePriority;
+  unsigned int mask;
   OOP processOOP;
   gst_process process;
   gst_semaphore processList;
@@ -1916,21 +2276,30 @@ would_reschedule_process ()
   process = (gst_process) OOP_TO_OBJ (processOOP);
   activePriority = TO_INT (process->priority);
   processLists = GET_PROCESS_LISTS ();
-  priority = NUM_OOPS (OOP_TO_OBJ (processLists));
-  do
+
+  /* Only look at the priorities that are not lower than the active
+     one.  */
+  mask = ready_priorities & ~((1U << activePriority) - 1);
+  for (;;)
     {
-      assert (priority > 0);
+      if (!mask)
+	return true;
+
+      priority = HIGHEST_PRIORITY (mask);
       processListOOP = ARRAY_AT (processLists, priority);
+      if (!is_empty (processListOOP))
+	break;
+
+      ready_priorities &= ~(1U << priority);
+      mask &= ~(1U << priority);
     }
-  while (is_empty (processListOOP) && --priority >= activePriority);
 
+  /* If the same priority, check if the list has the current process
+     as the sole element.  */
   processList = (gst_semaphore) OOP_TO_OBJ (processListOOP);
-  return (priority < activePriority
-	  || (priority == activePriority
-	      /* If the same priority, check if the list has the
-		 current process as the sole element.  */
-	      && processList->firstLink == processList->lastLink
-	      && processList->firstLink == processOOP));
+  return (priority == activePriority
+	  && processList->firstLink == processList->lastLink
+	  && processList->firstLink == processOOP);
 }
 
 OOP
@@ -1938,15 +2307,18 @@ highest_priority_process (void)
 {
   OOP processLists, processListOOP;
   int priority;
+  unsigned int mask;
   OOP processOOP;
   gst_semaphore processList;
 
   processLists = GET_PROCESS_LISTS ();
-  priority = NUM_OOPS (OOP_TO_OBJ (processLists));
-  for (; priority > 0; priority--)
+  for (mask = ready_priorities; mask; mask &= ~(1U << priority))
     {
+      priority = HIGHEST_PRIORITY (mask);
       processListOOP = ARRAY_AT (processLists, priority);
-      if (!is_empty (processListOOP))
+      if (is_empty (processListOOP))
+	ready_priorities &= ~(1U << priority);
+      else
 	{
 	  processOOP = remove_first_link (processListOOP);
 	  if (processOOP == get_scheduled_process ())
@@ -2096,10 +2468,21 @@ semaphore_new (int signals)
   return (semaphoreOOP);
 }
 
+void
+_gst_reset_bytecode_counter (void)
+{
+  /* switch_bytecodes is only ever subtracted from the counter, so
+     moving it back by the same amount keeps the difference.  */
+  switch_bytecodes -= _gst_bytecode_counter;
+  _gst_bytecode_counter = 0;
+}
+
 void
 _gst_init_process_system (void)
 {
   gst_processor_scheduler processor;
+  process_statistics *statistics;
+  OOP oop;
   int i;
 
   processor = (gst_processor_scheduler) OOP_TO_OBJ (_gst_processor_oop);
@@ -2118,6 +2501,24 @@ _gst_init_process_system (void)
     processor->processTimeslice =
       FROM_INT (DEFAULT_PREEMPTION_TIMESLICE);
 
+  /* The lists might come from a saved image.  */
+  ready_priorities = 0;
+  for (i = 1; i <= NUM_OOPS (OOP_TO_OBJ (processor->processLists)); i++)
+    if (!is_empty (ARRAY_AT (processor->processLists, i)))
+      MARK_READY_PRIORITY (i);
+
+  /* So might the statistics, but the clock of the session that saved
+     them does not go on in this one: forget about the waits that were
+     in progress.  */
+  for (oop = _gst_mem.ot; oop <= _gst_mem.last_allocated_oop; oop++)
+    if (!IS_OOP_FREE (oop)
+	&& is_a_kind_of (OOP_CLASS (oop), _gst_process_class)
+	&& (statistics = get_process_statistics (oop)))
+      statistics->waitStart = 0;
+
+  switch_time = _gst_get_ns_time ();
+  switch_bytecodes = _gst_bytecode_counter;
+
   /* No process is active -- so highest_priority_process() need not
      worry about discarding an active process.  */
   processor->activeProcess = _gst_nil_oop;
@@ -2154,6 +2555,7 @@ create_callin_process (OOP contextOOP)
 
   /* Put initialProcessOOP in the root set */
   add_first_link (initialProcessListOOP, initialProcessOOP);
+  MARK_READY_PRIORITY (4);
 
   _gst_invalidate_method_cache ();
   return (initialProcessOOP);
@@ -2178,6 +2580,10 @@ _gst_get_var (enum gst_var_index index)
       return (_gst_make_core_file);
     case GST_REGRESSION_TESTING:
       return (_gst_regression_testing);
+    case GST_PERF_MAP:
+      return (_gst_perf_map);
+    case GST_LEX_AHEAD:
+      return (_gst_lex_ahead);
     default:
       return (-1);
     }
@@ -2213,6 +2619,12 @@ _gst_set_var (enum gst_var_index index, int value)
     case GST_REGRESSION_TESTING:
       _gst_regression_testing = true;
       break;
+    case GST_PERF_MAP:
+      _gst_perf_map = value;
+      break;
+    case GST_LEX_AHEAD:
+      _gst_lex_ahead = value;
+      break;
     default:
       return (-1);
     }
@@ -2394,6 +2806,8 @@ _gst_copy_processor_registers (void)
   if (_gst_this_context_oop)
     MAYBE_COPY_OOP (_gst_this_context_oop);
 
+  scan_profile_samples (_gst_copy_oop_range);
+
   /* everything else is pointed to by _gst_this_context_oop, either
      directly or indirectly, or has been copyed when scanning the 
      registered roots.  */
@@ -2428,6 +2842,8 @@ _gst_mark_processor_registers (void)
   if (_gst_this_context_oop)
     MAYBE_MARK_OOP (_gst_this_context_oop);
 
+  scan_profile_samples (_gst_mark_oop_range);
+
   /* everything else is pointed to by _gst_this_context_oop, either
      directly or indirectly, or has been marked when scanning the 
      registered roots.  */
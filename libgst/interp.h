@@ -82,7 +82,8 @@ enum
   PRIM_MK_TEMP,                 /* base: */
   PRIM_GET_CHARS_AT,            /* data:from:to:absOfs: */
   PRIM_PUT_CHARS_AT,            /* data:from:to:absOfs: */
-  PRIM_SHUTDOWN_WRITE           /* shutdown */
+  PRIM_SHUTDOWN_WRITE,          /* shutdown */
+  PRIM_PUT_CHARS_VECTOR         /* chunks */
 };
 
 /* These macros are used to quickly compute the number of words needed
@@ -208,7 +209,8 @@ typedef struct gst_semaphore
   OOP name; \
   OOP unwindPoints; \
   OOP interrupts; \
-  OOP interruptLock
+  OOP interruptLock; \
+  OOP statistics
 
 typedef struct gst_process
 {
@@ -482,6 +484,11 @@ extern void _gst_restore_object_pointers (void)
 extern void _gst_init_process_system (void) 
   ATTRIBUTE_HIDDEN;
 
+/* Set _gst_bytecode_counter to zero, without losing the bytecodes
+   that the active process executed since it was switched to.  */
+extern void _gst_reset_bytecode_counter (void) 
+  ATTRIBUTE_HIDDEN;
+
 /* These function mark or copy all the objects that the interpreter keeps in
    the root set.  These are the semaphores that are held to be
    signaled by an asynchronous event (note that they *are* in the root
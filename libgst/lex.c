@@ -77,7 +77,7 @@
 #define SYMBOL_CHAR		16
 
 /* The obstack containing parse tree nodes.  */
-struct obstack *_gst_compilation_obstack = NULL;
+THREAD_LOCAL struct obstack *_gst_compilation_obstack = NULL;
 
 /* True if errors must be reported to the standard error, false if
    errors should instead stored so that they are passed to Smalltalk
@@ -88,7 +88,7 @@ mst_Boolean _gst_report_errors = true;
    (respectively, a parse error or a semantic error) is found, and
    avoids that _gst_execute_statements tries to execute the result of
    the compilation.  */
-mst_Boolean _gst_had_error = false;
+THREAD_LOCAL mst_Boolean _gst_had_error = false;
 
 /* This is set to true by the parser if error recovery is going on.
    In this case ERROR_RECOVERY tokens are generated.  */
@@ -196,6 +196,20 @@ static int string_literal (int c,
 static int scan_number (int c,
 			 YYSTYPE * lvalp);
 
+/* Parse a decimal SmallInteger whose digits are all in memory, and
+   store it in LVALP.  C is the first digit.  Return false, without
+   consuming anything, if the number might be something else.  */
+static mst_Boolean scan_small_integer (int c,
+				       YYSTYPE * lvalp);
+
+/* Skip white space and comments as long as they are in memory.  */
+static void skip_blanks (void);
+
+/* Add to the compilation obstack the characters of the current
+   stream that are in memory and have one of the bits in CHAR_CLASS
+   set, consuming them.  */
+static void scan_run (int char_class);
+
 /* Parse an identifier.  C is the first letter.  */
 static int scan_ident (int c,
 			YYSTYPE * lvalp);
@@ -383,9 +397,20 @@ _gst_yylex (PTR lvalp, YYLTYPE *llocp)
 {
   int ic, result;
   const lex_tab_elt *ct;
+  lex_ahead la;
 
-  while ((ic = _gst_next_char ()) != EOF)
+  /* If the stream is being scanned by another thread, just get the
+     next token from it.  */
+  la = _gst_get_cur_stream_lex_ahead ();
+  if (la)
+    return (_gst_next_scanned_token (la, (YYSTYPE *) lvalp, llocp));
+
+  for (;;)
     {
+      skip_blanks ();
+      if ((ic = _gst_next_char ()) == EOF)
+	break;
+
       ct = CHAR_TAB (ic);
       if ((ct->char_class & WHITE_SPACE) == 0)
 	{
@@ -408,6 +433,52 @@ _gst_yylex (PTR lvalp, YYLTYPE *llocp)
   *llocp = _gst_get_location ();
   return (EOF);
 }
+
+void
+skip_blanks (void)
+{
+  const char *p, *q, *end, *start;
+
+  p = start = _gst_get_cur_stream_buffer (&end);
+  if (!p)
+    return;
+
+  /* Newlines are blanks too, because the buffer is not there for
+     interactive streams.  An unterminated comment is left to the
+     comment function, which reports the error.  */
+  while (p < end)
+    {
+      if (*p == '\n'
+	  || (CHAR_TAB ((unsigned char) *p)->char_class & WHITE_SPACE))
+	p++;
+      else if (*p == '"' && (q = memchr (p + 1, '"', end - p - 1)))
+	p = q + 1;
+      else
+	break;
+    }
+
+  if (p != start)
+    _gst_advance_cur_stream (p);
+}
+
+void
+scan_run (int char_class)
+{
+  const char *p, *end, *start;
+
+  p = start = _gst_get_cur_stream_buffer (&end);
+  if (!p)
+    return;
+
+  while (p < end && (CHAR_TAB ((unsigned char) *p)->char_class & char_class))
+    p++;
+
+  if (p != start)
+    {
+      obstack_grow (_gst_compilation_obstack, start, p - start);
+      _gst_advance_cur_stream (p);
+    }
+}
 
 
 
@@ -492,8 +563,14 @@ int
 comment (int c,
 	 YYSTYPE * lvalp)
 {
+  const char *p, *q, *end;
   int ic;
 
+  /* Go straight to the end of the comment if it is in memory.  */
+  p = _gst_get_cur_stream_buffer (&end);
+  if (p && (q = memchr (p, c, end - p)))
+    _gst_advance_cur_stream (q);
+
   do
     {
       ic = _gst_next_char ();
@@ -600,6 +677,7 @@ scan_symbol (int c,
 
   obstack_1grow (_gst_compilation_obstack, ic);
 
+  scan_run (SYMBOL_CHAR);
   while (((ic = _gst_next_char ()) != EOF)
          && (CHAR_TAB (ic)->char_class & SYMBOL_CHAR))
     obstack_1grow (_gst_compilation_obstack, ic);
@@ -666,10 +744,23 @@ int
 string_literal (int c,
 		YYSTYPE * lvalp)
 {
+  const char *p, *q, *end;
   int ic;
 
   for (;;)
     {
+      /* Copy everything up to the next delimiter at once.  */
+      p = _gst_get_cur_stream_buffer (&end);
+      if (p)
+	{
+	  q = memchr (p, c, end - p);
+	  if (!q)
+	    q = end;
+
+	  obstack_grow (_gst_compilation_obstack, p, q - p);
+	  _gst_advance_cur_stream (q);
+	}
+
       ic = _gst_next_char ();
       if (ic == EOF)
 	{
@@ -704,6 +795,7 @@ scan_ident (int c,
 
   identType = IDENTIFIER;
 
+  scan_run (ID_CHAR);
   while (((ic = _gst_next_char ()) != EOF)
 	 && (CHAR_TAB (ic)->char_class & ID_CHAR))
     obstack_1grow (_gst_compilation_obstack, ic);
@@ -748,11 +840,51 @@ scan_ident (int c,
  * and just save the bytes for large integers.  We should just save
  * the bytes and work on those.  */
 
+mst_Boolean
+scan_small_integer (int c,
+		    YYSTYPE * lvalp)
+{
+  const char *p, *end, *start;
+  intptr_t value;
+
+  p = start = _gst_get_cur_stream_buffer (&end);
+  if (!p)
+    return (false);
+
+  /* Nine digits always fit in a SmallInteger.  */
+  for (value = c - '0'; p < end && is_digit ((unsigned char) *p); p++)
+    {
+      if (p - start == 8)
+	return (false);
+
+      value = value * 10 + *p - '0';
+    }
+
+  /* Leave radixes, fractions, exponents, scales and digit separators
+     to scan_number, as well as numbers at the end of the buffer.  */
+  if (p == end)
+    return (false);
+
+  switch (*p)
+    {
+    case '_': case 'r': case 'e': case 'd': case 'q': case 's':
+      return (false);
+
+    case '.':
+      if (p + 1 == end || is_digit ((unsigned char) p[1]))
+	return (false);
+    }
+
+  _gst_advance_cur_stream (p);
+  lvalp->ival = value;
+  return (true);
+}
+
 int
 scan_number (int c,
 	      YYSTYPE * lvalp)
 {
-  OOP intNumOOP;
+  struct scaled_decimal_literal sd;
   int base, exponent, ic;
   uintptr_t intNum;
   struct real num, dummy;
@@ -760,6 +892,9 @@ scan_number (int c,
   mst_Boolean isNegative = false, largeInteger = false;
   int float_type = 0;
 
+  if (scan_small_integer (c, lvalp))
+    return (INTEGER_LITERAL);
+
   base = 10;
   exponent = 0;
   ic = c;
@@ -839,33 +974,27 @@ scan_number (int c,
 	  _gst_unread_char (ic);
 
         if (largeInteger)
+	  sd.bo = scan_large_integer (isNegative, base);
+        else
           {
-	    /* Make a LargeInteger constant and create an object out of
-	       it.  */
-	    byte_object bo = scan_large_integer (isNegative, base);
-	    gst_object result = instantiate_with (bo->class, bo->size, &intNumOOP);
-            memcpy (result->data, bo->body, bo->size);
+            char *p = obstack_finish (_gst_compilation_obstack);
+            obstack_free (_gst_compilation_obstack, p);
+	    sd.bo = NULL;
 	  }
-        else
-          intNumOOP = FROM_INT((intptr_t) (isNegative ? -intNum : intNum));
-
-	/* too much of a chore to create a Fraction, so we call-in. We
-	   lose the ability to create ScaledDecimals during the very
-	   first phases of bootstrapping, but who cares?... 
-
-	   This is equivalent to 
-		(intNumOOP * (10 raisedToInteger: exponent)
-		   asScaledDecimal: floatExponent) */
-	lvalp->oval =
-	  _gst_msg_send (intNumOOP, _gst_as_scaled_decimal_radix_scale_symbol,
-			 FROM_INT (exponent),
-			 FROM_INT (base),
-			 FROM_INT ((int) floatExponent), 
-			 NULL);
-
-	/* incubator is set up by _gst_compile_method */
-	INC_ADD_OOP (lvalp->oval);
-	MAKE_OOP_READONLY (lvalp->oval, true);
+
+	sd.num = (intptr_t) (isNegative ? -intNum : intNum);
+	sd.exponent = exponent;
+	sd.base = base;
+	sd.scale = floatExponent;
+
+	/* A lexer thread cannot create objects; the main thread will
+	   do that when it gets the token.  */
+	if (_gst_current_lex_ahead)
+	  lvalp->sdval = obstack_copy (_gst_compilation_obstack, &sd,
+				       sizeof (sd));
+	else
+	  lvalp->oval = _gst_make_scaled_decimal (&sd);
+
 	return (SCALED_DECIMAL_LITERAL);
       }
     while (0);
@@ -1161,6 +1290,42 @@ scan_large_integer (mst_Boolean negative,
 }
 
 
+OOP
+_gst_make_scaled_decimal (scaled_decimal_literal sd)
+{
+  OOP intNumOOP, resultOOP;
+
+  if (sd->bo)
+    {
+      /* Make a LargeInteger constant and create an object out of
+	 it.  */
+      gst_object result = instantiate_with (sd->bo->class, sd->bo->size,
+					    &intNumOOP);
+      memcpy (result->data, sd->bo->body, sd->bo->size);
+    }
+  else
+    intNumOOP = FROM_INT (sd->num);
+
+  /* too much of a chore to create a Fraction, so we call-in. We
+     lose the ability to create ScaledDecimals during the very
+     first phases of bootstrapping, but who cares?... 
+
+     This is equivalent to 
+	(intNumOOP * (10 raisedToInteger: exponent)
+	   asScaledDecimal: floatExponent) */
+  resultOOP =
+    _gst_msg_send (intNumOOP, _gst_as_scaled_decimal_radix_scale_symbol,
+		   FROM_INT (sd->exponent),
+		   FROM_INT (sd->base),
+		   FROM_INT (sd->scale), 
+		   NULL);
+
+  /* incubator is set up by _gst_compile_method */
+  INC_ADD_OOP (resultOOP);
+  MAKE_OOP_READONLY (resultOOP, true);
+  return (resultOOP);
+}
+
 OOP
 _gst_parse_method_from_stream (OOP currentClass, OOP currentCategory)
 {
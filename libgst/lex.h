@@ -65,12 +65,26 @@ typedef struct byte_object
 }
  *byte_object;
 
+/* A structure holding a ScaledDecimal constant, for when the lexer
+   runs in a thread that cannot create objects.  BO is NULL unless
+   the number does not fit in NUM.  */
+typedef struct scaled_decimal_literal
+{
+  byte_object bo;
+  intptr_t num;
+  int exponent;
+  int base;
+  int scale;
+}
+ *scaled_decimal_literal;
+
 typedef union YYSTYPE {
   long double          fval;
   intptr_t             ival;
   char                *sval;
   byte_object          boval;
   OOP                  oval;
+  scaled_decimal_literal sdval;
   struct tree_node    *node;
 } YYSTYPE;
 
@@ -92,7 +106,7 @@ extern mst_Boolean _gst_report_errors
    (respectively, a parse error or a semantic error) is found, and
    avoids that _gst_execute_statements tries to execute the result of
    the compilation.  */
-extern mst_Boolean _gst_had_error
+extern THREAD_LOCAL mst_Boolean _gst_had_error
   ATTRIBUTE_HIDDEN;
 
 /* This is set to true by the parser if error recovery is going on.
@@ -109,7 +123,7 @@ extern int _gst_first_error_line
   ATTRIBUTE_HIDDEN;
 
 /* The obstack containing parse tree nodes.  */
-extern struct obstack *_gst_compilation_obstack 
+extern THREAD_LOCAL struct obstack *_gst_compilation_obstack 
   ATTRIBUTE_HIDDEN;
 
 /* Parse a method from the topmost stream in the stack.  */
@@ -132,6 +146,11 @@ extern void _gst_yyprint (FILE * file,
 			  PTR lval) 
   ATTRIBUTE_HIDDEN;
 
+/* Create the ScaledDecimal described by SD, which was scanned by a
+   lexer thread, and add it to the incubator.  */
+extern OOP _gst_make_scaled_decimal (scaled_decimal_literal sd)
+  ATTRIBUTE_HIDDEN;
+
 /* Negate the semantic value YYLVAL, which must be a numeric token
    of type TOKEN.  Returns true if YYLVAL is positive, false if it
    is negative.  */
@@ -0,0 +1,539 @@
+/******************************** -*- C -*- ****************************
+ *
+ *	Scanning files in a separate thread
+ *
+ *
+ ***********************************************************************/
+
+/***********************************************************************
+ *
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Smalltalk.
+ *
+ * GNU Smalltalk is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later 
+ * version.
+ * 
+ * Linking GNU Smalltalk statically or dynamically with other modules is
+ * making a combined work based on GNU Smalltalk.  Thus, the terms and
+ * conditions of the GNU General Public License cover the whole
+ * combination.
+ *
+ * In addition, as a special exception, the Free Software Foundation
+ * give you permission to combine GNU Smalltalk with free software
+ * programs or libraries that are released under the GNU LGPL and with
+ * independent programs running under the GNU Smalltalk virtual machine.
+ *
+ * You may copy and distribute such a system following the terms of the
+ * GNU GPL for GNU Smalltalk and the licenses of the other code
+ * concerned, provided that you include the source code of that other
+ * code when and as the GNU GPL requires distribution of source code.
+ *
+ * Note that people who make modified versions of GNU Smalltalk are not
+ * obligated to grant this special exception for their modified
+ * versions; it is their choice whether to do so.  The GNU General
+ * Public License gives permission to release a modified version without
+ * this exception; this exception also makes it possible to release a
+ * modified version which carries forward this exception.
+ *
+ * GNU Smalltalk is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * GNU Smalltalk; see the file COPYING.  If not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.  
+ *
+ ***********************************************************************/
+
+
+#include "gstpriv.h"
+
+#ifdef ENABLE_LEX_AHEAD
+#include <pthread.h>
+#endif
+
+/* The lexer thread stops when this many chunks are waiting for the
+   parser, each holding at least TOKENS_PER_CHUNK tokens.  */
+#define TOKENS_PER_CHUNK	512
+#define MAX_QUEUED_CHUNKS	64
+
+/* The token value used for errors; the semantic value is the
+   message, allocated with malloc.  */
+#define ERROR_TOKEN		0
+
+typedef struct scanned_token
+{
+  int token;
+  YYSTYPE val;
+  YYLTYPE loc;
+
+  /* The location of the last character read after the token.  */
+  YYLTYPE end;
+} scanned_token;
+
+/* A group of tokens.  The strings, LargeIntegers and ScaledDecimals
+   they refer to are stored in STRINGS, so they are freed together
+   with the chunk.  */
+typedef struct token_chunk
+{
+  struct token_chunk *next;
+  scanned_token *tokens;
+  int count;
+  int size;
+  struct obstack strings;
+} *token_chunk;
+
+struct lex_ahead
+{
+#ifdef ENABLE_LEX_AHEAD
+  pthread_t thread;
+
+  /* Protects FIRST, LAST, QUEUED and STOP.  COND is signaled when a
+     chunk is added to or removed from the queue, or when STOP is
+     set.  */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+
+  token_chunk first, last;
+  int queued;
+  mst_Boolean stop;
+
+  /* FINISHING is set before a fork to let the lexer thread scan the
+     rest of the file without waiting for the parser; FINISHED is set
+     by the thread when it is done.  Both are protected by MUTEX.
+     FORKED is set in the child process, where the thread does not
+     exist.  */
+  mst_Boolean finishing;
+  mst_Boolean finished;
+  mst_Boolean forked;
+
+  /* The next file being scanned by a lexer thread.  */
+  struct lex_ahead *next_live;
+
+  /* The chunk that the parser is reading, and the index of its next
+     token.  Only accessed by the main thread.  */
+  token_chunk cur;
+  int next;
+  YYLTYPE end;
+
+  /* The chunk that the lexer thread is filling.  */
+  token_chunk filling;
+
+  /* The input for the lexer thread.  */
+  char *buf;
+  size_t size;
+  int line;
+  int column;
+  off_t offset;
+};
+
+int _gst_lex_ahead = 1;
+
+THREAD_LOCAL lex_ahead _gst_current_lex_ahead = NULL;
+
+#ifdef ENABLE_LEX_AHEAD
+/* The files that are being scanned.  Only accessed by the main
+   thread.  */
+static lex_ahead live_lex_aheads = NULL;
+
+/* The lexer thread.  ARG is the lex_ahead for the file.  */
+static void *lex_ahead_thread (void *arg);
+
+/* Allocate an empty chunk.  */
+static token_chunk new_chunk (void);
+
+/* Free CHUNK and everything it refers to.  */
+static void free_chunk (token_chunk chunk);
+
+/* Reserve space for one more token in CHUNK and return it.  */
+static scanned_token *add_token (token_chunk chunk);
+
+/* Pass CHUNK to the main thread, waiting if too many chunks are
+   queued.  Return false (and free CHUNK) if the main thread asked
+   the lexer thread to stop.  */
+static mst_Boolean queue_chunk (lex_ahead la,
+				token_chunk chunk);
+
+/* Wait for the lexer thread to queue a chunk, and remove it from
+   the queue.  */
+static token_chunk dequeue_chunk (lex_ahead la);
+
+
+
+lex_ahead
+_gst_start_lex_ahead (char *buf,
+		      size_t size,
+		      int line,
+		      int column,
+		      off_t offset)
+{
+  lex_ahead la;
+
+  la = (lex_ahead) xcalloc (1, sizeof (struct lex_ahead));
+  la->buf = buf;
+  la->size = size;
+  la->line = line;
+  la->column = column;
+  la->offset = offset;
+  pthread_mutex_init (&la->mutex, NULL);
+  pthread_cond_init (&la->cond, NULL);
+
+  if (pthread_create (&la->thread, NULL, lex_ahead_thread, la) != 0)
+    {
+      pthread_cond_destroy (&la->cond);
+      pthread_mutex_destroy (&la->mutex);
+      xfree (buf);
+      xfree (la);
+      return (NULL);
+    }
+
+  la->next_live = live_lex_aheads;
+  live_lex_aheads = la;
+  return (la);
+}
+
+void
+_gst_stop_lex_ahead (lex_ahead la)
+{
+  token_chunk chunk;
+  lex_ahead *p;
+
+  for (p = &live_lex_aheads; *p != la; p = &(*p)->next_live);
+  *p = la->next_live;
+
+  /* The thread of a forked child's lex_ahead ran in the parent.  */
+  if (!la->forked)
+    {
+      pthread_mutex_lock (&la->mutex);
+      la->stop = true;
+      pthread_cond_broadcast (&la->cond);
+      pthread_mutex_unlock (&la->mutex);
+      pthread_join (la->thread, NULL);
+    }
+
+  if (la->cur)
+    free_chunk (la->cur);
+
+  while ((chunk = la->first))
+    {
+      la->first = chunk->next;
+      free_chunk (chunk);
+    }
+
+  pthread_cond_destroy (&la->cond);
+  pthread_mutex_destroy (&la->mutex);
+  xfree (la);
+}
+
+int
+_gst_next_scanned_token (lex_ahead la,
+			 YYSTYPE *lvalp,
+			 YYLTYPE *llocp)
+{
+  scanned_token *tok;
+
+  for (;;)
+    {
+      if (!la->cur || la->next == la->cur->count)
+	{
+	  if (la->cur)
+	    free_chunk (la->cur);
+
+	  la->cur = dequeue_chunk (la);
+	  la->next = 0;
+	}
+
+      tok = &la->cur->tokens[la->next];
+      *llocp = tok->loc;
+      la->end = tok->end;
+
+      /* Keep answering EOF if the parser asks for more tokens.  */
+      if (tok->token != EOF)
+        la->next++;
+
+      switch (tok->token)
+	{
+	case ERROR_TOKEN:
+	  _gst_errorf_at (tok->loc.first_line, "%s", tok->val.sval);
+	  _gst_had_error = true;
+	  continue;
+
+	case IDENTIFIER:
+	case KEYWORD:
+	case BINOP:
+	case STRING_LITERAL:
+	case SYMBOL_LITERAL:
+	case '|':
+	case '<':
+	case '>':
+	case '-':
+	  lvalp->sval = obstack_copy0 (_gst_compilation_obstack,
+				       tok->val.sval, strlen (tok->val.sval));
+	  break;
+
+	case LARGE_INTEGER_LITERAL:
+	  lvalp->boval = obstack_copy (_gst_compilation_obstack,
+				       tok->val.boval,
+				       sizeof (struct byte_object)
+				       + tok->val.boval->size);
+	  break;
+
+	case SCALED_DECIMAL_LITERAL:
+	  lvalp->oval = _gst_make_scaled_decimal (tok->val.sdval);
+	  break;
+
+	default:
+	  *lvalp = tok->val;
+	  break;
+	}
+
+      return (tok->token);
+    }
+}
+
+YYLTYPE
+_gst_lex_ahead_location (lex_ahead la)
+{
+  return (la->end);
+}
+
+void
+_gst_lex_ahead_before_fork (void)
+{
+  lex_ahead la;
+
+  for (la = live_lex_aheads; la; la = la->next_live)
+    {
+      pthread_mutex_lock (&la->mutex);
+      la->finishing = true;
+      pthread_cond_broadcast (&la->cond);
+      while (!la->finished)
+	pthread_cond_wait (&la->cond, &la->mutex);
+      pthread_mutex_unlock (&la->mutex);
+    }
+}
+
+void
+_gst_lex_ahead_after_fork (mst_Boolean child)
+{
+  lex_ahead la;
+
+  for (la = live_lex_aheads; la; la = la->next_live)
+    {
+      la->finishing = false;
+      if (child)
+	la->forked = true;
+    }
+
+  /* Threads could be unsafe in the child, so scan on the main
+     thread from now on.  */
+  if (child)
+    _gst_lex_ahead = 0;
+}
+
+void
+_gst_lex_ahead_error (lex_ahead la,
+		      const char *str,
+		      va_list ap)
+{
+  scanned_token *tok;
+
+  /* The obstack may hold a partially scanned token, so the message
+     is allocated separately.  */
+  tok = add_token (la->filling);
+  tok->token = ERROR_TOKEN;
+  vasprintf (&tok->val.sval, str, ap);
+  tok->loc = tok->end = _gst_get_location ();
+}
+
+
+void *
+lex_ahead_thread (void *arg)
+{
+  lex_ahead la = (lex_ahead) arg;
+  token_chunk chunk;
+  scanned_token *tok;
+  YYSTYPE val;
+  YYLTYPE loc;
+  int token;
+  sigset_t set;
+
+  /* Leave the signals used by the VM to the interpreter thread.  */
+  sigfillset (&set);
+  pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+  _gst_current_lex_ahead = la;
+  _gst_push_buffer (la->buf, la->size, la->line, la->column, la->offset);
+
+  do
+    {
+      chunk = la->filling = new_chunk ();
+      _gst_compilation_obstack = &chunk->strings;
+      do
+	{
+	  token = _gst_yylex (&val, &loc);
+	  tok = add_token (chunk);
+	  tok->token = token;
+	  tok->val = val;
+	  tok->loc = loc;
+	  tok->end = _gst_get_location ();
+	}
+      while (token != EOF && chunk->count < TOKENS_PER_CHUNK);
+    }
+  while (queue_chunk (la, chunk) && token != EOF);
+
+  /* This frees the buffer.  */
+  _gst_pop_stream (false);
+
+  pthread_mutex_lock (&la->mutex);
+  la->finished = true;
+  pthread_cond_broadcast (&la->cond);
+  pthread_mutex_unlock (&la->mutex);
+  return (NULL);
+}
+
+token_chunk
+new_chunk (void)
+{
+  token_chunk chunk;
+
+  chunk = (token_chunk) xmalloc (sizeof (struct token_chunk));
+  chunk->next = NULL;
+  chunk->count = 0;
+  chunk->size = TOKENS_PER_CHUNK;
+  chunk->tokens = (scanned_token *) xmalloc (chunk->size
+					     * sizeof (scanned_token));
+  obstack_init (&chunk->strings);
+  return (chunk);
+}
+
+void
+free_chunk (token_chunk chunk)
+{
+  int i;
+
+  for (i = 0; i < chunk->count; i++)
+    if (chunk->tokens[i].token == ERROR_TOKEN)
+      free (chunk->tokens[i].val.sval);
+
+  obstack_free (&chunk->strings, NULL);
+  xfree (chunk->tokens);
+  xfree (chunk);
+}
+
+scanned_token *
+add_token (token_chunk chunk)
+{
+  /* Errors can make a chunk longer than TOKENS_PER_CHUNK.  */
+  if (chunk->count == chunk->size)
+    {
+      chunk->size *= 2;
+      chunk->tokens = (scanned_token *)
+	xrealloc (chunk->tokens, chunk->size * sizeof (scanned_token));
+    }
+
+  return (&chunk->tokens[chunk->count++]);
+}
+
+mst_Boolean
+queue_chunk (lex_ahead la,
+	     token_chunk chunk)
+{
+  pthread_mutex_lock (&la->mutex);
+  while (la->queued == MAX_QUEUED_CHUNKS && !la->stop && !la->finishing)
+    pthread_cond_wait (&la->cond, &la->mutex);
+
+  if (la->stop)
+    {
+      pthread_mutex_unlock (&la->mutex);
+      free_chunk (chunk);
+      return (false);
+    }
+
+  if (la->last)
+    la->last->next = chunk;
+  else
+    la->first = chunk;
+
+  la->last = chunk;
+  la->queued++;
+  pthread_cond_signal (&la->cond);
+  pthread_mutex_unlock (&la->mutex);
+  return (true);
+}
+
+token_chunk
+dequeue_chunk (lex_ahead la)
+{
+  token_chunk chunk;
+
+  pthread_mutex_lock (&la->mutex);
+  while (!la->first)
+    pthread_cond_wait (&la->cond, &la->mutex);
+
+  chunk = la->first;
+  la->first = chunk->next;
+  if (!la->first)
+    la->last = NULL;
+
+  la->queued--;
+  pthread_cond_signal (&la->cond);
+  pthread_mutex_unlock (&la->mutex);
+  return (chunk);
+}
+
+#else /* !ENABLE_LEX_AHEAD */
+
+lex_ahead
+_gst_start_lex_ahead (char *buf,
+		      size_t size,
+		      int line,
+		      int column,
+		      off_t offset)
+{
+  xfree (buf);
+  return (NULL);
+}
+
+void
+_gst_stop_lex_ahead (lex_ahead la)
+{
+}
+
+int
+_gst_next_scanned_token (lex_ahead la,
+			 YYSTYPE *lvalp,
+			 YYLTYPE *llocp)
+{
+  abort ();
+}
+
+YYLTYPE
+_gst_lex_ahead_location (lex_ahead la)
+{
+  return (la->end);
+}
+
+void
+_gst_lex_ahead_before_fork (void)
+{
+}
+
+void
+_gst_lex_ahead_after_fork (mst_Boolean child)
+{
+}
+
+void
+_gst_lex_ahead_error (lex_ahead la,
+		      const char *str,
+		      va_list ap)
+{
+  abort ();
+}
+#endif /* !ENABLE_LEX_AHEAD */
@@ -0,0 +1,128 @@
+/******************************** -*- C -*- ****************************
+ *
+ *	Lexer thread definitions
+ *
+ *
+ ***********************************************************************/
+
+/***********************************************************************
+ *
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Smalltalk.
+ *
+ * GNU Smalltalk is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later 
+ * version.
+ * 
+ * Linking GNU Smalltalk statically or dynamically with other modules is
+ * making a combined work based on GNU Smalltalk.  Thus, the terms and
+ * conditions of the GNU General Public License cover the whole
+ * combination.
+ *
+ * In addition, as a special exception, the Free Software Foundation
+ * give you permission to combine GNU Smalltalk with free software
+ * programs or libraries that are released under the GNU LGPL and with
+ * independent programs running under the GNU Smalltalk virtual machine.
+ *
+ * You may copy and distribute such a system following the terms of the
+ * GNU GPL for GNU Smalltalk and the licenses of the other code
+ * concerned, provided that you include the source code of that other
+ * code when and as the GNU GPL requires distribution of source code.
+ *
+ * Note that people who make modified versions of GNU Smalltalk are not
+ * obligated to grant this special exception for their modified
+ * versions; it is their choice whether to do so.  The GNU General
+ * Public License gives permission to release a modified version without
+ * this exception; this exception also makes it possible to release a
+ * modified version which carries forward this exception.
+ *
+ * GNU Smalltalk is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * GNU Smalltalk; see the file COPYING.  If not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.  
+ *
+ ***********************************************************************/
+
+
+#ifndef GST_LEXAHEAD_H
+#define GST_LEXAHEAD_H
+
+/* When a file is filed in, a separate thread can scan it while the
+   parser and the compiler work on the main thread.  The lexer thread
+   reads the file from memory and never creates objects, so it hands
+   to the main thread the few tokens that need them (ScaledDecimals)
+   in a raw form; errors are also queued, and reported in order when
+   the parser reaches them.  */
+#if defined HAVE_THREAD_LOCAL && defined HAVE_PREAD && !defined _WIN32
+#define ENABLE_LEX_AHEAD 1
+#endif
+
+/* Files shorter than this are scanned on the main thread.  */
+#define LEX_AHEAD_MIN_SIZE 8192
+
+typedef struct lex_ahead *lex_ahead;
+
+/* Nonzero if long files are scanned in a separate thread.  */
+extern int _gst_lex_ahead
+  ATTRIBUTE_HIDDEN;
+
+/* In a lexer thread, the file that it is scanning; NULL in the main
+   thread.  */
+extern THREAD_LOCAL lex_ahead _gst_current_lex_ahead
+  ATTRIBUTE_HIDDEN;
+
+/* Start a thread that scans the SIZE bytes at BUF, which begin at
+   byte OFFSET of the file, on line LINE and column COLUMN.  BUF is
+   freed by the thread.  Return NULL (and free BUF) if the thread
+   could not be started.  */
+extern lex_ahead _gst_start_lex_ahead (char *buf,
+				       size_t size,
+				       int line,
+				       int column,
+				       off_t offset)
+  ATTRIBUTE_HIDDEN;
+
+/* Stop the thread scanning LA, and free LA.  */
+extern void _gst_stop_lex_ahead (lex_ahead la)
+  ATTRIBUTE_HIDDEN;
+
+/* Return the next token scanned by LA, and store its semantic value
+   in LVALP and its location in LLOCP.  Strings are copied to the
+   compilation obstack, and errors found while scanning the token
+   are reported.  Wait if the thread has not scanned it yet.  */
+extern int _gst_next_scanned_token (lex_ahead la,
+				    YYSTYPE *lvalp,
+				    YYLTYPE *llocp)
+  ATTRIBUTE_HIDDEN;
+
+/* Return the location of the last character of the token that
+   _gst_next_scanned_token returned last.  */
+extern YYLTYPE _gst_lex_ahead_location (lex_ahead la)
+  ATTRIBUTE_HIDDEN;
+
+/* Called before fork: let the lexer threads scan the rest of their
+   files, because they are not copied to the child process.  */
+extern void _gst_lex_ahead_before_fork (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Called after fork in both processes; CHILD is true in the child,
+   where the files being scanned are read from the tokens that were
+   queued before the fork and new files are scanned on the main
+   thread.  */
+extern void _gst_lex_ahead_after_fork (mst_Boolean child)
+  ATTRIBUTE_HIDDEN;
+
+/* Called in a lexer thread to queue an error message, formatted
+   from STR and AP, for the main thread.  */
+extern void _gst_lex_ahead_error (lex_ahead la,
+				  const char *str,
+				  va_list ap)
+  ATTRIBUTE_HIDDEN;
+
+#endif /* GST_LEXAHEAD_H */
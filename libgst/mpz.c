@@ -1593,6 +1593,107 @@ _gst_mpz_divexact (gst_mpz *quot, const gst_mpz *num, const gst_mpz *den)
   quot->size = (num->size ^ den->size) >= 0 ? qsize : -qsize;
 }
 
+size_t
+_gst_mpz_sizeinbase (const gst_mpz *mpz, int base)
+{
+  mp_size_t size = ABS (mpz->size);
+  int log2_base;
+
+  while (size > 0 && mpz->d[size - 1] == 0)
+    size--;
+
+  if (size == 0)
+    return 1;
+
+  /* Dividing by the floor of log2(BASE) gives an upper bound.  */
+  for (log2_base = 1; (2 << log2_base) <= base; log2_base++);
+  return size * BITS_PER_MP_LIMB / log2_base + 1;
+}
+
+size_t
+_gst_mpz_get_str (char *str, int base, const gst_mpz *mpz)
+{
+  static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  mp_size_t size = ABS (mpz->size);
+  unsigned char *p;
+  mp_ptr tp;
+  size_t len, i;
+  char *start = str;
+
+  while (size > 0 && mpz->d[size - 1] == 0)
+    size--;
+
+  if (size == 0)
+    {
+      *str = '0';
+      return 1;
+    }
+
+  if (mpz->size < 0)
+    *str++ = '-';
+
+  /* mpn_get_str destroys its input, which might point directly into
+     a LargeInteger.  */
+  tp = (mp_ptr) xmalloc (size * SIZEOF_MP_LIMB_T);
+  MPN_COPY (tp, mpz->d, size);
+  p = (unsigned char *) str;
+  len = mpn_get_str (p, base, tp, size);
+  xfree (tp);
+
+  for (i = 0; i < len - 1 && p[i] == 0; i++);
+  len -= i;
+  memmove (p, p + i, len);
+  for (i = 0; i < len; i++)
+    str[i] = digits[p[i]];
+
+  return str + len - start;
+}
+
+mst_Boolean
+_gst_mpz_set_str (gst_mpz *mpz, const char *str, size_t len, int base)
+{
+  unsigned char *digits, *p;
+  size_t i;
+  int log2_base;
+
+  digits = (unsigned char *) xmalloc (len ? len : 1);
+  for (i = 0; i < len; i++)
+    {
+      int c = str[i];
+      if (c >= '0' && c <= '9')
+	digits[i] = c - '0';
+      else if (c >= 'A' && c <= 'Z')
+	digits[i] = c - 'A' + 10;
+      else if (c >= 'a' && c <= 'z')
+	digits[i] = c - 'a' + 10;
+      else
+	digits[i] = 255;
+
+      if (digits[i] >= base)
+	{
+	  xfree (digits);
+	  return (false);
+	}
+    }
+
+  /* mpn_set_str wants no leading zeros.  */
+  for (p = digits; len > 0 && *p == 0; p++, len--);
+  if (len == 0)
+    {
+      gst_mpz_realloc (mpz, 1);
+      mpz->size = 0;
+      xfree (digits);
+      return (true);
+    }
+
+  /* Multiplying by the ceiling of log2(BASE) gives an upper bound.  */
+  for (log2_base = 1; (1 << log2_base) < base; log2_base++);
+  gst_mpz_realloc (mpz, len * log2_base / BITS_PER_MP_LIMB + 1);
+  mpz->size = mpn_set_str (mpz->d, p, len, base);
+  xfree (digits);
+  return (true);
+}
+
 void
 _gst_mpz_from_oop(gst_mpz *mpz, OOP srcOOP)
 {
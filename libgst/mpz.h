@@ -132,6 +132,26 @@ void _gst_mpz_set (gst_mpz *, const gst_mpz *)
 void _gst_mpz_clear (gst_mpz *m) 
   ATTRIBUTE_HIDDEN;
 
+/* Answer an upper bound on the number of digits in the base BASE
+   representation of the absolute value of an integer.  */
+size_t _gst_mpz_sizeinbase (const gst_mpz *, int base) 
+  ATTRIBUTE_HIDDEN;
+
+/* Store in STR the base BASE representation of an integer, with
+   uppercase letters for digits above 9 and a leading minus sign if
+   it is negative, and answer its length.  STR is not NUL-terminated
+   and must have room for _gst_mpz_sizeinbase + 2 characters.  */
+size_t _gst_mpz_get_str (char *str, int base, const gst_mpz *) 
+  ATTRIBUTE_HIDDEN;
+
+/* Set an integer to the value of the LEN base BASE digits in STR,
+   most significant first, where letters of either case stand for
+   the digits above 9.  Answer false if STR has a character that is
+   not a digit in that base.  */
+mst_Boolean _gst_mpz_set_str (gst_mpz *, const char *str, size_t len,
+			      int base) 
+  ATTRIBUTE_HIDDEN;
+
 /* Create an integer from an OOP (an instance of a subclass of
    Integer).  Space from the object itself is pointed to on
    little-endian machines, so you should care that no GC's happen
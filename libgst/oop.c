@@ -128,6 +128,94 @@ struct statistical_data
     timeOfLastCompaction;
 } stats;
 
+/* An allocation sample.  The class and the method are part of the
+   root set, and must stay next to each other; the sampled object is
+   only referenced weakly, and only if survivors are tracked.  */
+typedef struct alloc_sample
+{
+  OOP classOOP;
+  OOP methodOOP;
+  OOP oop;
+  intptr_t offset;
+  size_t size;
+  size_t bytes;
+  int survived;
+} alloc_sample;
+
+/* The most allocation samples that are kept; the others are lost.  */
+#define MAX_ALLOC_SAMPLES	(1 << 20)
+
+/* The value of _gst_alloc_sample_countdown when sampling is off.  */
+#define NO_ALLOC_SAMPLE		((intptr_t) (~(uintptr_t) 0 >> 1))
+
+intptr_t _gst_alloc_sample_countdown = NO_ALLOC_SAMPLE;
+
+/* The allocation samples, and the parameters of the sampling.  */
+static alloc_sample *alloc_samples;
+static size_t num_alloc_samples, max_alloc_samples;
+static size_t alloc_sample_interval;
+static mst_Boolean alloc_track_survivors;
+
+/* The number of garbage collection events that are remembered.  */
+#define GC_EVENT_BUFFER_SIZE	256
+
+/* The kinds of garbage collection events.  */
+enum gc_event_kind
+{
+  GC_EVENT_SCAVENGE,
+  GC_EVENT_GLOBAL,
+  GC_EVENT_COMPACT,
+  GC_EVENT_INCREMENTAL
+};
+
+/* The spaces whose usage is recorded in a garbage collection event.  */
+enum gc_event_space
+{
+  GC_SPACE_EDEN,
+  GC_SPACE_SURVIVOR,
+  GC_SPACE_OLD,
+  GC_SPACE_FIXED,
+  GC_NUM_SPACES
+};
+
+/* Counters that are updated by the garbage collector, and whose
+   increase is recorded in each event.  */
+typedef struct gc_counters
+{
+  size_t tenured;
+  size_t ephemerons;
+  size_t weak_objects;
+  size_t weak_refs_cleared;
+} gc_counters;
+
+/* A garbage collection event.  Times are in nanoseconds.  */
+typedef struct gc_event
+{
+  uint64_t id;
+  int kind;
+  uint64_t start, pause;
+  size_t before[GC_NUM_SPACES], after[GC_NUM_SPACES];
+  gc_counters counts;
+} gc_event;
+
+/* The ring buffer of garbage collection events, and the number of
+   events recorded so far.  */
+static gc_event gc_events[GC_EVENT_BUFFER_SIZE];
+static uint64_t num_gc_events;
+
+/* The steps of an incremental sweep are merged into a single event,
+   which is kept here until the sweep finishes or another event
+   starts.  */
+static gc_event *open_incremental_event;
+
+/* The counters for the events, and the number of events that are
+   being recorded.  Nested events are also part of the outer ones.  */
+static gc_counters gc_event_counters;
+static int gc_event_depth;
+
+/* The file where events are written as JSON lines, or NULL.  */
+static FILE *gc_event_log;
+
 
 
 /* Allocates a table for OOPs of SIZE bytes, and store pointers to the
@@ -244,6 +332,30 @@ static inline void mark_ephemeron_oops (void);
    not surviving the garbage collection.  Called by preare_for_sweep.  */
 static inline void check_weak_refs ();
 
+/* Pass the classes and methods of the allocation samples to FUNC,
+   which marks or copies them.  */
+static void scan_alloc_samples (void (*func) (OOP *, OOP *));
+
+/* Count the sampled objects that survived a collection, and forget
+   those that did not.  Called after check_weak_refs.  */
+static void check_alloc_samples (void);
+
+/* Store in USAGE the number of bytes used in each space.  */
+static void get_space_usage (size_t *usage);
+
+/* Start recording the garbage collection event EV, of the given KIND.  */
+static void begin_gc_event (gc_event *ev,
+			    int kind);
+
+/* Finish recording EV and add it to the ring buffer.  */
+static void end_gc_event (gc_event *ev);
+
+/* Write EV to the event log, if there is one.  */
+static void log_gc_event (gc_event *ev);
+
+/* Log the pending incremental sweep event, if any, and forget it.  */
+static void close_incremental_event (void);
+
 
 void
 init_survivor_space (struct surv_space *space, size_t size)
@@ -757,6 +869,7 @@ _gst_tenure_oop (OOP oop)
 
   oop->flags &= ~(F_SPACES | F_POOLED);
   oop->flags |= F_OLD;
+  gc_event_counters.tenured++;
 }
 
 
@@ -790,6 +903,365 @@ _gst_alloc_obj (size_t size,
   return p_instance;
 }
 
+void
+_gst_sample_allocation (OOP oop,
+			size_t size)
+{
+  alloc_sample *sample;
+  size_t n;
+
+  if (!alloc_sample_interval)
+    {
+      _gst_alloc_sample_countdown = NO_ALLOC_SAMPLE;
+      return;
+    }
+
+  /* A big object can stand for more than one interval.  */
+  n = ((size_t) -_gst_alloc_sample_countdown + alloc_sample_interval - 1)
+    / alloc_sample_interval;
+  _gst_alloc_sample_countdown += (intptr_t) (n * alloc_sample_interval);
+
+  if (num_alloc_samples == max_alloc_samples)
+    {
+      if (max_alloc_samples == MAX_ALLOC_SAMPLES)
+	return;
+
+      max_alloc_samples = max_alloc_samples ? max_alloc_samples * 2 : 1024;
+      alloc_samples = (alloc_sample *)
+	xrealloc (alloc_samples, max_alloc_samples * sizeof (alloc_sample));
+    }
+
+  sample = &alloc_samples[num_alloc_samples++];
+  sample->classOOP = OOP_CLASS (oop);
+  sample->methodOOP = _gst_nil_oop;
+  sample->oop = alloc_track_survivors ? oop : NULL;
+  sample->offset = -1;
+  sample->size = size;
+  sample->bytes = n * alloc_sample_interval;
+  sample->survived = 0;
+
+  if (!_gst_this_method || IS_NIL (_gst_this_method))
+    return;
+
+  sample->methodOOP = _gst_this_method;
+
+#ifndef ENABLE_JIT_TRANSLATION
+  {
+    /* The instruction pointer is only exported at sequence points, so
+       check that it lies in the method.  */
+    gst_compiled_method method =
+      (gst_compiled_method) OOP_TO_OBJ (_gst_this_method);
+
+    if (ip >= method->bytecodes
+        && ip <= method->bytecodes + NUM_INDEXABLE_FIELDS (_gst_this_method))
+      sample->offset = ip - method->bytecodes;
+  }
+#endif
+}
+
+void
+_gst_set_allocation_sampling (size_t interval,
+			      mst_Boolean track_survivors)
+{
+  alloc_sample_interval = interval;
+  num_alloc_samples = 0;
+  if (!interval)
+    {
+      /* The samples would keep their classes and methods alive.  */
+      _gst_alloc_sample_countdown = NO_ALLOC_SAMPLE;
+      alloc_track_survivors = false;
+      xfree (alloc_samples);
+      alloc_samples = NULL;
+      max_alloc_samples = 0;
+      return;
+    }
+
+  alloc_track_survivors = track_survivors;
+  _gst_alloc_sample_countdown = interval;
+}
+
+OOP
+_gst_allocation_samples (void)
+{
+  OOP resultOOP, sampleOOP;
+  alloc_sample *sample;
+  inc_ptr incPtr;
+  intptr_t countdown;
+  size_t i, n;
+
+  /* Do not sample the arrays that are created here.  */
+  countdown = _gst_alloc_sample_countdown;
+  _gst_alloc_sample_countdown = NO_ALLOC_SAMPLE;
+
+  n = num_alloc_samples;
+  incPtr = INC_SAVE_POINTER ();
+  instantiate_with (_gst_array_class, n, &resultOOP);
+  INC_ADD_OOP (resultOOP);
+
+  /* Instantiating the arrays can trigger a collection, which can
+     remove the sampled objects; the class and method stay valid.  */
+  for (i = 0; i < n; i++)
+    {
+      instantiate_with (_gst_array_class, 7, &sampleOOP);
+      sample = &alloc_samples[i];
+      ARRAY_AT_PUT (sampleOOP, 1, sample->classOOP);
+      ARRAY_AT_PUT (sampleOOP, 2, sample->methodOOP);
+      if (sample->offset >= 0)
+	ARRAY_AT_PUT (sampleOOP, 3, FROM_INT (sample->offset));
+      ARRAY_AT_PUT (sampleOOP, 4, FROM_INT (sample->size));
+      ARRAY_AT_PUT (sampleOOP, 5, FROM_INT (sample->bytes));
+      if (alloc_track_survivors)
+	{
+	  ARRAY_AT_PUT (sampleOOP, 6, FROM_INT (sample->survived));
+	  if (sample->oop)
+	    ARRAY_AT_PUT (sampleOOP, 7, sample->oop);
+	}
+
+      ARRAY_AT_PUT (resultOOP, i + 1, sampleOOP);
+    }
+
+  INC_RESTORE_POINTER (incPtr);
+  _gst_alloc_sample_countdown = countdown;
+  return resultOOP;
+}
+
+void
+scan_alloc_samples (void (*func) (OOP *, OOP *))
+{
+  size_t i;
+
+  for (i = 0; i < num_alloc_samples; i++)
+    func (&alloc_samples[i].classOOP, &alloc_samples[i].methodOOP + 1);
+}
+
+void
+check_alloc_samples (void)
+{
+  size_t i;
+
+  for (i = 0; i < num_alloc_samples; i++)
+    {
+      OOP oop = alloc_samples[i].oop;
+      if (!oop)
+	continue;
+
+      if (IS_OOP_VALID_GC (oop))
+	alloc_samples[i].survived++;
+      else
+	alloc_samples[i].oop = NULL;
+    }
+}
+
+void
+get_space_usage (size_t *usage)
+{
+  usage[GC_SPACE_EDEN] =
+    (char *) _gst_mem.eden.allocPtr - (char *) _gst_mem.eden.minPtr;
+  usage[GC_SPACE_SURVIVOR] = _gst_mem.active_half->filled;
+  usage[GC_SPACE_OLD] = _gst_mem.old->heap_total;
+  usage[GC_SPACE_FIXED] = _gst_mem.fixed->heap_total;
+}
+
+void
+begin_gc_event (gc_event *ev,
+		int kind)
+{
+  gc_event_depth++;
+  ev->kind = kind;
+  ev->counts = gc_event_counters;
+  get_space_usage (ev->before);
+  ev->start = _gst_get_ns_time ();
+}
+
+void
+end_gc_event (gc_event *ev)
+{
+  gc_event *dest;
+
+  ev->pause = _gst_get_ns_time () - ev->start;
+  get_space_usage (ev->after);
+  ev->counts.tenured = gc_event_counters.tenured - ev->counts.tenured;
+  ev->counts.ephemerons =
+    gc_event_counters.ephemerons - ev->counts.ephemerons;
+  ev->counts.weak_objects =
+    gc_event_counters.weak_objects - ev->counts.weak_objects;
+  ev->counts.weak_refs_cleared =
+    gc_event_counters.weak_refs_cleared - ev->counts.weak_refs_cleared;
+  gc_event_depth--;
+
+  if (ev->kind == GC_EVENT_INCREMENTAL && open_incremental_event)
+    {
+      dest = open_incremental_event;
+      dest->pause += ev->pause;
+      memcpy (dest->after, ev->after, sizeof (dest->after));
+      dest->counts.tenured += ev->counts.tenured;
+      dest->counts.ephemerons += ev->counts.ephemerons;
+      dest->counts.weak_objects += ev->counts.weak_objects;
+      dest->counts.weak_refs_cleared += ev->counts.weak_refs_cleared;
+    }
+  else
+    {
+      close_incremental_event ();
+      ev->id = num_gc_events;
+      dest = &gc_events[num_gc_events++ % GC_EVENT_BUFFER_SIZE];
+      *dest = *ev;
+      if (dest->kind != GC_EVENT_INCREMENTAL)
+	{
+	  log_gc_event (dest);
+	  return;
+	}
+
+      open_incremental_event = dest;
+    }
+
+  if (!incremental_gc_running ())
+    close_incremental_event ();
+}
+
+void
+close_incremental_event (void)
+{
+  if (!open_incremental_event)
+    return;
+
+  log_gc_event (open_incremental_event);
+  open_incremental_event = NULL;
+}
+
+void
+log_gc_event (gc_event *ev)
+{
+  static const char *kinds[] = {
+    "scavenge", "global", "compact", "incremental"
+  };
+
+  if (!gc_event_log)
+    return;
+
+  fprintf (gc_event_log,
+	   "{\"id\":%llu,\"kind\":\"%s\",\"start\":%llu,\"pause\":%llu,"
+	   "\"eden\":[%lu,%lu],\"survivor\":[%lu,%lu],"
+	   "\"old\":[%lu,%lu],\"fixed\":[%lu,%lu],"
+	   "\"tenured\":%lu,\"ephemerons\":%lu,"
+	   "\"weakObjects\":%lu,\"weakRefsCleared\":%lu}\n",
+	   (unsigned long long) ev->id, kinds[ev->kind],
+	   (unsigned long long) ev->start, (unsigned long long) ev->pause,
+	   (unsigned long) ev->before[GC_SPACE_EDEN],
+	   (unsigned long) ev->after[GC_SPACE_EDEN],
+	   (unsigned long) ev->before[GC_SPACE_SURVIVOR],
+	   (unsigned long) ev->after[GC_SPACE_SURVIVOR],
+	   (unsigned long) ev->before[GC_SPACE_OLD],
+	   (unsigned long) ev->after[GC_SPACE_OLD],
+	   (unsigned long) ev->before[GC_SPACE_FIXED],
+	   (unsigned long) ev->after[GC_SPACE_FIXED],
+	   (unsigned long) ev->counts.tenured,
+	   (unsigned long) ev->counts.ephemerons,
+	   (unsigned long) ev->counts.weak_objects,
+	   (unsigned long) ev->counts.weak_refs_cleared);
+  fflush (gc_event_log);
+}
+
+mst_Boolean
+_gst_set_gc_event_log (const char *file_name)
+{
+  FILE *f = NULL;
+
+  if (file_name)
+    {
+      f = fopen (file_name, "a");
+      if (!f)
+	return false;
+    }
+
+  if (gc_event_log)
+    fclose (gc_event_log);
+
+  gc_event_log = f;
+  return true;
+}
+
+OOP
+_gst_gc_events (void)
+{
+  OOP resultOOP, eventOOP, valueOOP;
+  gc_event *ev;
+  uint64_t values[16];
+  inc_ptr incPtr;
+  uint64_t first;
+  int i, j, n;
+
+  first = num_gc_events > GC_EVENT_BUFFER_SIZE
+    ? num_gc_events - GC_EVENT_BUFFER_SIZE : 0;
+  n = num_gc_events - first;
+
+  /* Copy the events first, since creating the arrays can trigger a
+     collection that adds more.  */
+  ev = (gc_event *) alloca (n * sizeof (gc_event));
+  for (i = 0; i < n; i++)
+    ev[i] = gc_events[(first + i) % GC_EVENT_BUFFER_SIZE];
+
+  incPtr = INC_SAVE_POINTER ();
+  instantiate_with (_gst_array_class, n, &resultOOP);
+  INC_ADD_OOP (resultOOP);
+
+  for (i = 0; i < n; i++)
+    {
+      values[0] = ev[i].id;
+      values[1] = ev[i].kind;
+      values[2] = ev[i].start;
+      values[3] = ev[i].pause;
+      for (j = 0; j < GC_NUM_SPACES; j++)
+	{
+	  values[4 + 2 * j] = ev[i].before[j];
+	  values[5 + 2 * j] = ev[i].after[j];
+	}
+
+      values[12] = ev[i].counts.tenured;
+      values[13] = ev[i].counts.ephemerons;
+      values[14] = ev[i].counts.weak_objects;
+      values[15] = ev[i].counts.weak_refs_cleared;
+
+      instantiate_with (_gst_array_class, 16, &eventOOP);
+      ARRAY_AT_PUT (resultOOP, i + 1, eventOOP);
+      for (j = 0; j < 16; j++)
+	{
+	  /* This can allocate a LargePositiveInteger.  */
+	  valueOOP = FROM_C_ULONGLONG (values[j]);
+	  ARRAY_AT_PUT (eventOOP, j + 1, valueOOP);
+	}
+    }
+
+  INC_RESTORE_POINTER (incPtr);
+  return resultOOP;
+}
+
+mst_Boolean
+_gst_grow_in_place (OOP oop,
+		    size_t delta)
+{
+  gst_object obj = OOP_TO_OBJ (oop);
+  size_t size = TO_INT (obj->objSize);
+  OOP *end = (OOP *) obj + size;
+  OOP *newEnd = end + delta;
+
+  if (oop->flags & (F_OLD | F_FIXED | F_LOADED)
+      || (OOP *) obj < _gst_mem.eden.minPtr
+      || end != _gst_mem.eden.allocPtr)
+    return (false);
+
+  /* Big objects belong in oldspace, leave them to the caller.  */
+  if (newEnd >= _gst_mem.eden.maxPtr
+      || SIZE_TO_BYTES (size + delta) >= _gst_mem.big_object_threshold)
+    return (false);
+
+  while (end < newEnd)
+    *end++ = _gst_nil_oop;
+
+  _gst_mem.eden.allocPtr = newEnd;
+  obj->objSize = FROM_INT (size + delta);
+  return (true);
+}
+
 gst_object
 alloc_fixed_obj (size_t size,
 	         OOP *p_oop)
@@ -1004,7 +1476,11 @@ void
 compact (size_t new_heap_limit)
 {
   OOP oop;
-  heap_data *new_heap = init_old_space (
+  heap_data *new_heap;
+  gc_event ev;
+
+  begin_gc_event (&ev, GC_EVENT_COMPACT);
+  new_heap = init_old_space (
     new_heap_limit ? new_heap_limit : _gst_mem.old->heap_limit);
 
   if (new_heap_limit)
@@ -1049,6 +1525,7 @@ compact (size_t new_heap_limit)
   _gst_restore_object_pointers ();
 
   update_stats (&stats.timeOfLastCompaction, NULL, &_gst_mem.timeToCompact);
+  end_gc_event (&ev);
 }
 
 
@@ -1064,7 +1541,9 @@ _gst_global_gc (int next_allocation)
 {
   const char *s;
   int old_limit;
+  gc_event ev;
 
+  begin_gc_event (&ev, GC_EVENT_GLOBAL);
   _gst_mem.numGlobalGCs++;
 
   old_limit = _gst_mem.old->heap_limit;
@@ -1097,6 +1576,7 @@ _gst_global_gc (int next_allocation)
   _gst_mem.live_flags &= ~F_OLD;
   _gst_mem.live_flags |= F_REACHABLE;
   check_weak_refs ();
+  check_alloc_samples ();
   _gst_restore_object_pointers ();
 #if defined (GC_DEBUGGING)
   _gst_check_oop_table ();
@@ -1128,7 +1608,7 @@ _gst_global_gc (int next_allocation)
 			     ((next_allocation + _gst_mem.old->heap_total)
 			      * (100.0 + _gst_mem.space_grow_rate)
 			      / _gst_mem.grow_threshold_percent));
-	  if (target_limit < old_limit)
+	  if (target_limit < old_limit && !_gst_mem.shared_heap)
             {
               s = "done, heap compacted";
               compact (0);
@@ -1169,12 +1649,14 @@ _gst_global_gc (int next_allocation)
 
   _gst_invalidate_croutine_cache ();
   mourn_objects ();
+  end_gc_event (&ev);
 }
 
 void
 _gst_scavenge (void)
 {
   int oldBytes, reclaimedBytes, tenuredBytes, reclaimedPercent;
+  gc_event ev;
 
   /* Check if oldspace had to be grown in emergency.  */
   size_t prev_heap_limit = _gst_mem.old->heap_limit;
@@ -1191,6 +1673,7 @@ _gst_scavenge (void)
       return;
     }
 
+  begin_gc_event (&ev, GC_EVENT_SCAVENGE);
   if (!_gst_gc_running++
       && _gst_gc_message
       && _gst_verbosity > 2
@@ -1218,6 +1701,7 @@ _gst_scavenge (void)
   _gst_fixup_object_pointers ();
   copy_oops ();
   check_weak_refs ();
+  check_alloc_samples ();
   _gst_restore_object_pointers ();
   reset_incremental_gc (_gst_mem.ot);
 
@@ -1254,6 +1738,7 @@ _gst_scavenge (void)
 
   _gst_invalidate_croutine_cache ();
   mourn_objects ();
+  end_gc_event (&ev);
 
   /* If tenuring had to grow oldspace, do a global garbage collection
      now.  */
@@ -1276,6 +1761,13 @@ void
 _gst_finish_incremental_gc ()
 {
   OOP oop, firstOOP;
+  gc_event ev;
+  mst_Boolean traced;
+
+  /* Only sweeps that are not part of another event are recorded.  */
+  traced = !gc_event_depth && incremental_gc_running ();
+  if (traced)
+    begin_gc_event (&ev, GC_EVENT_INCREMENTAL);
 
 #if defined (GC_DEBUG_OUTPUT)
   printf ("Completing sweep (%p...%p), validity flags %x\n", _gst_mem.last_swept_oop,
@@ -1303,6 +1795,8 @@ _gst_finish_incremental_gc ()
 
   _gst_mem.next_oop_to_sweep = oop;
   _gst_finished_incremental_gc ();
+  if (traced)
+    end_gc_event (&ev);
 }
 
 void
@@ -1332,11 +1826,17 @@ mst_Boolean
 _gst_incremental_gc_step ()
 {
   OOP oop, firstOOP;
+  gc_event ev;
+  mst_Boolean traced;
   int i;
 
   if (!incremental_gc_running ())
     return true;
 
+  traced = !gc_event_depth;
+  if (traced)
+    begin_gc_event (&ev, GC_EVENT_INCREMENTAL);
+
   i = 0;
   firstOOP = _gst_mem.last_swept_oop;
   for (oop = _gst_mem.next_oop_to_sweep; oop > firstOOP; oop--)
@@ -1355,6 +1855,8 @@ _gst_incremental_gc_step ()
 	  if (++i == INCREMENTAL_SWEEP_STEP)
 	    {
 	      _gst_mem.next_oop_to_sweep = oop - 1;
+	      if (traced)
+		end_gc_event (&ev);
 	      return false;
 	    }
         }
@@ -1362,6 +1864,8 @@ _gst_incremental_gc_step ()
 
   _gst_mem.next_oop_to_sweep = oop;
   _gst_finished_incremental_gc ();
+  if (traced)
+    end_gc_event (&ev);
   return true;
 }
 
@@ -1708,6 +2212,8 @@ check_weak_refs ()
       if (!IS_OOP_VALID_GC (oop))
 	continue;
 
+      gc_event_counters.weak_objects++;
+
       for (field = (OOP *) oop->object + OBJ_HEADER_SIZE_WORDS,
 	   n = NUM_OOPS (oop->object); n--; field++)
         {
@@ -1719,6 +2225,7 @@ check_weak_refs ()
             {
               mourn = true;
 	      *field = _gst_nil_oop;
+	      gc_event_counters.weak_refs_cleared++;
 	    }
         }
 
@@ -1754,6 +2261,7 @@ copy_oops (void)
   /* Do these last since they are often alive only till the next
      scavenge.  */
   _gst_copy_processor_registers ();
+  scan_alloc_samples (_gst_copy_oop_range);
   cheney_scan ();
 
   scan_grey_objects ();
@@ -1901,6 +2409,8 @@ scan_grey_objects()
         {
 	  OOP key = obj->data[0];
 
+	  gc_event_counters.ephemerons++;
+
 	  /* Copy the key, mourn the object if it was not reachable.  */
 	  if (!IS_OOP_COPIED (key))
 	    {
@@ -2088,6 +2598,7 @@ mark_oops (void)
   _gst_reset_buffer ();
   _gst_mark_registered_oops ();
   _gst_mark_processor_registers ();
+  scan_alloc_samples (_gst_mark_oop_range);
   mark_ephemeron_oops ();
 }
 
@@ -2103,6 +2614,7 @@ mark_ephemeron_oops (void)
   _gst_copy_buffer (base);
   _gst_reset_buffer ();
   size /= sizeof (PTR);
+  gc_event_counters.ephemerons += size;
 
   /* First pass: distinguish objects whose key was reachable from
      the outside by clearing their F_EPHEMERON bit.  */
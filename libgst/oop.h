@@ -259,6 +259,12 @@ struct memory_space
      used exceeds _gst_grow_threshold_percent.  */
   int space_grow_rate;
 
+  /* True in a virtual machine that was forked from another one.  The
+     old space is then shared copy-on-write with the parent; marking
+     only touches the OOP table, but compacting would copy every page,
+     so it is not done automatically after a global GC.  */
+  mst_Boolean shared_heap;
+
   /* Some statistics are computed using exponential smoothing.  The smoothing
      factor is stored here.  */
   double factor;
@@ -329,6 +335,21 @@ extern void _gst_finish_incremental_gc (void)
 extern void _gst_tenure_all_survivors () 
   ATTRIBUTE_HIDDEN;
 
+/* Answer an Array with an Array for each event in the ring buffer of
+   garbage collection events, oldest first: the sequence number, the
+   kind, the start time and the pause in nanoseconds, the bytes used
+   in eden, survivor space, oldspace and fixedspace before and after
+   the event, the number of tenured objects, of ephemerons, of weak
+   objects scanned and of weak references cleared.  */
+extern OOP _gst_gc_events (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Append a line with a JSON object describing each garbage collection
+   event to the file named FILE_NAME, or stop if FILE_NAME is NULL.
+   Answer whether the file could be opened.  */
+extern mst_Boolean _gst_set_gc_event_log (const char *file_name)
+  ATTRIBUTE_HIDDEN;
+
 /* Initialize the memory allocator.  The memory space is allocated,
    and the various garbage collection flags are set to their initial
    values.  */
@@ -411,6 +432,50 @@ extern gst_object _gst_alloc_obj (size_t size,
 				  OOP *p_oop) 
   ATTRIBUTE_HIDDEN;
 
+/* The number of bytes that can still be allocated before the next
+   allocation sample is taken.  */
+extern intptr_t _gst_alloc_sample_countdown
+  ATTRIBUTE_HIDDEN;
+
+/* Record the class of OOP, which was just allocated with SIZE bytes,
+   together with the method and bytecode that allocated it.  Called
+   by MAYBE_SAMPLE_ALLOCATION; it must not allocate objects.  */
+extern void _gst_sample_allocation (OOP oop,
+				    size_t size)
+  ATTRIBUTE_HIDDEN;
+
+/* Sample one allocation every INTERVAL bytes, or stop sampling if
+   INTERVAL is zero.  In both cases the previous samples are
+   discarded.  If TRACK_SURVIVORS is true, the garbage collector also
+   counts how many collections each sampled object survives.  */
+extern void _gst_set_allocation_sampling (size_t interval,
+					  mst_Boolean track_survivors)
+  ATTRIBUTE_HIDDEN;
+
+/* Answer an Array with an Array for each allocation sample: the
+   class, the method or nil, the bytecode offset or nil, the size of
+   the object, the number of allocated bytes that the sample stands
+   for, the number of collections it survived and the object itself
+   if it is still alive (the last two are nil unless survivors are
+   tracked).  */
+extern OOP _gst_allocation_samples (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Take an allocation sample for OOP, whose size is SIZE bytes, if the
+   sampling interval has elapsed.  */
+#define MAYBE_SAMPLE_ALLOCATION(oop, size) do {			\
+  if UNCOMMON ((_gst_alloc_sample_countdown -= (intptr_t) (size)) < 0) \
+    _gst_sample_allocation ((oop), (size));			\
+} while (0)
+
+/* Add DELTA words, initialized to nil, at the end of the object
+   pointed to by OOP without moving it.  This is only possible if
+   it is the newest object in eden and there is room after it; answer
+   whether the object was grown.  */
+extern mst_Boolean _gst_grow_in_place (OOP oop,
+				       size_t delta)
+  ATTRIBUTE_HIDDEN;
+
 /* Allocate and return space for an object of SIZE words, without
    creating an OOP.  This is a special operation that is only needed
    at bootstrap time, so it does not care about garbage collection.  */
@@ -0,0 +1,1129 @@
+/******************************** -*- C -*- ****************************
+ *
+ *	Precompiled packages
+ *
+ *
+ ***********************************************************************/
+
+/***********************************************************************
+ *
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Smalltalk.
+ *
+ * GNU Smalltalk is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later 
+ * version.
+ * 
+ * Linking GNU Smalltalk statically or dynamically with other modules is
+ * making a combined work based on GNU Smalltalk.  Thus, the terms and
+ * conditions of the GNU General Public License cover the whole
+ * combination.
+ *
+ * In addition, as a special exception, the Free Software Foundation
+ * give you permission to combine GNU Smalltalk with free software
+ * programs or libraries that are released under the GNU LGPL and with
+ * independent programs running under the GNU Smalltalk virtual machine.
+ *
+ * You may copy and distribute such a system following the terms of the
+ * GNU GPL for GNU Smalltalk and the licenses of the other code
+ * concerned, provided that you include the source code of that other
+ * code when and as the GNU GPL requires distribution of source code.
+ *
+ * Note that people who make modified versions of GNU Smalltalk are not
+ * obligated to grant this special exception for their modified
+ * versions; it is their choice whether to do so.  The GNU General
+ * Public License gives permission to release a modified version without
+ * this exception; this exception also makes it possible to release a
+ * modified version which carries forward this exception.
+ *
+ * GNU Smalltalk is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * GNU Smalltalk; see the file COPYING.  If not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.  
+ *
+ ***********************************************************************/
+
+
+#include "gstpriv.h"
+
+/* The header of a precompiled package.  The data is in the native
+   byte order and word size of the virtual machine that wrote it, and
+   refers to primitives by number, so the header has enough
+   information to reject packages written by a different VM.  */
+typedef struct precomp_header
+{
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t oop_size;
+  unsigned char prim_table_md5[16];
+  uint32_t num_objects;
+  uint32_t reserved;
+} precomp_header;
+
+#define PRECOMP_MAGIC		"GSTPKG2\n"
+#define PRECOMP_BYTE_ORDER	0x01020304
+
+/* The tags that introduce an object in a precompiled package.
+   Symbols, classes, metaclasses, namespaces, bindings and objects
+   are numbered in the order they are first written, and later
+   occurrences are written as a TAG_BACKREF with that number.  */
+#define TAG_SMALLINTEGER	'i'	/* followed by the OOP */
+#define TAG_NIL			'n'
+#define TAG_TRUE		't'
+#define TAG_FALSE		'f'
+#define TAG_CHARACTER		'c'	/* followed by the value */
+#define TAG_BACKREF		'r'	/* followed by the number */
+#define TAG_SYMBOL		's'	/* followed by size and bytes */
+#define TAG_GLOBAL		'g'	/* followed by environment, name
+					   and shape if a class */
+#define TAG_METACLASS		'm'	/* followed by the instance class
+					   and shape */
+#define TAG_BINDING		'b'	/* followed by namespace and key */
+#define TAG_POOL_BINDING	'p'	/* followed by class and key */
+#define TAG_OBJECT		'o'	/* followed by class, flags, sizes
+					   and contents */
+
+/* Flags stored for a TAG_OBJECT.  */
+#define OBJECT_READONLY		1
+#define OBJECT_UNTRUSTED	2
+
+typedef struct oop_index_entry
+{
+  OOP oop;
+  size_t index;
+} oop_index_entry;
+
+/* The state of the recording.  OBJECTS holds the objects that were
+   numbered, and is registered with the garbage collector so that
+   an OOP is not reused while the recording refers to it.  HASH maps
+   the OOPs back to their number.  */
+typedef struct precomp_recorder
+{
+  mst_Boolean active;
+  mst_Boolean failed;
+  int level;
+  gst_uchar *buf;
+  size_t size, max;
+  OOP *objects, *objects_end;
+  size_t objects_max;
+  oop_index_entry *hash;
+  size_t hash_size;
+} precomp_recorder;
+
+/* The state of a call to _gst_precomp_next_event.  Every object that
+   is loaded is stored in OBJECTSOOP as soon as it is created, which
+   also protects it from the garbage collector.  */
+typedef struct precomp_loader
+{
+  OOP bytesOOP;
+  size_t pos, size;
+  OOP objectsOOP;
+  size_t count, max;
+  OOP *post_load;
+  size_t post_load_size, post_load_max;
+  jmp_buf bad_data;
+} precomp_loader;
+
+/* Nothing is recorded until _gst_precomp_start sets LEVEL to 0.  */
+static precomp_recorder recorder = { false, false, 1 };
+
+/* The innermost watch started by _gst_precomp_watch.  */
+static precomp_watch *watch = NULL;
+
+/* Answer whether an event should be recorded now.  */
+static inline mst_Boolean is_recording (void);
+
+/* Count an event in the innermost watch if it happened at the watch's
+   level.  METHODOOP is the method of a doit, NULL for other events.  */
+static inline void watch_event (OOP receiverOOP,
+				OOP methodOOP);
+
+/* Append N bytes starting at P to the recording.  */
+static void put_bytes (const PTR p,
+		       size_t n);
+
+/* Append the byte C to the recording.  */
+static inline void put_byte (int c);
+
+/* Append the count N to the recording.  */
+static inline void put_count (size_t n);
+
+/* Answer the number of OOP in the recording, or -1.  */
+static intptr_t lookup_object (OOP oop);
+
+/* Give the next number to OOP.  */
+static void add_object (OOP oop);
+
+/* Answer the object named NAMEOOP in the namespace ENVIRONMENTOOP,
+   or in Smalltalk if it is nil.  */
+static OOP global_at (OOP environmentOOP,
+		      OOP nameOOP);
+
+/* Write a reference to OOP, writing OOP itself if it was not written
+   yet.  */
+static void write_ref (OOP oop);
+
+/* Write a class or namespace, which is stored by name.  */
+static void write_global (OOP oop);
+
+/* Write the instanceSpec and the instance variable names of CLASSOOP.
+   The methods of a package hard-code the index of the instance
+   variables of the classes they are compiled in, including those
+   that come from prerequisites, so the shape is checked on load.  */
+static void write_shape (OOP classOOP);
+
+/* Write a VariableBinding, which is stored as the key and the owner of
+   the dictionary that holds it.  */
+static void write_binding (OOP oop);
+
+/* Write any other object, which is stored by value.  */
+static void write_object (OOP oop);
+
+/* Read N bytes from the package into DEST.  */
+static void get_bytes (precomp_loader *l,
+		       PTR dest,
+		       size_t n);
+
+/* Read a byte from the package.  */
+static inline int get_byte (precomp_loader *l);
+
+/* Read a count from the package.  */
+static inline size_t get_count (precomp_loader *l);
+
+/* Give the next number to OOP and answer it.  */
+static OOP add_loaded (precomp_loader *l,
+		       OOP oop);
+
+/* Read a reference to an object, loading the object if necessary.  */
+static OOP read_ref (precomp_loader *l);
+
+/* Read a Symbol and intern it.  */
+static OOP read_symbol (precomp_loader *l);
+
+/* Read the shape written by write_shape, and abort unless CLASSOOP
+   still has it.  */
+static void check_shape (precomp_loader *l,
+			 OOP classOOP);
+
+/* Read a VariableBinding tagged with TAG, creating it if it does not
+   exist.  */
+static OOP read_binding (precomp_loader *l,
+			 int tag);
+
+/* Read an object that was stored by value.  */
+static OOP read_object (precomp_loader *l);
+
+/* Abort the current call to _gst_precomp_next_event.  */
+static void bad_data (precomp_loader *l) ATTRIBUTE_NORETURN;
+
+
+mst_Boolean
+is_recording (void)
+{
+  return recorder.active && recorder.level == 0 && !recorder.failed;
+}
+
+void
+watch_event (OOP receiverOOP,
+	     OOP methodOOP)
+{
+  if (!watch || recorder.level != watch->level)
+    return;
+
+  if (watch->events++ == 0 && methodOOP)
+    {
+      watch->receiverOOP = receiverOOP;
+      watch->methodOOP = methodOOP;
+      _gst_register_oop (receiverOOP);
+      _gst_register_oop (methodOOP);
+    }
+}
+
+void
+put_bytes (const PTR p,
+	   size_t n)
+{
+  if (recorder.size + n > recorder.max)
+    {
+      recorder.max = MAX (recorder.max * 2, recorder.size + n);
+      recorder.buf = (gst_uchar *) xrealloc (recorder.buf, recorder.max);
+    }
+
+  memcpy (recorder.buf + recorder.size, p, n);
+  recorder.size += n;
+}
+
+void
+put_byte (int c)
+{
+  gst_uchar b = c;
+  put_bytes (&b, 1);
+}
+
+void
+put_count (size_t n)
+{
+  uint32_t u = n;
+  put_bytes (&u, sizeof (u));
+}
+
+intptr_t
+lookup_object (OOP oop)
+{
+  size_t mask = recorder.hash_size - 1;
+  size_t i = scramble (OOP_INDEX (oop)) & mask;
+
+  for (; recorder.hash[i].oop; i = (i + 1) & mask)
+    if (recorder.hash[i].oop == oop)
+      return recorder.hash[i].index;
+
+  return -1;
+}
+
+void
+add_object (OOP oop)
+{
+  size_t n = recorder.objects_end - recorder.objects;
+  size_t i, mask;
+
+  if (n == recorder.objects_max)
+    {
+      recorder.objects_max *= 2;
+      recorder.objects = (OOP *)
+	xrealloc (recorder.objects, recorder.objects_max * sizeof (OOP));
+      recorder.objects_end = recorder.objects + n;
+    }
+
+  *recorder.objects_end++ = oop;
+
+  /* Keep the hash table at most half full.  */
+  if (2 * (n + 1) > recorder.hash_size)
+    {
+      oop_index_entry *old = recorder.hash;
+      size_t old_size = recorder.hash_size;
+
+      recorder.hash_size *= 2;
+      recorder.hash = (oop_index_entry *)
+	xcalloc (recorder.hash_size, sizeof (oop_index_entry));
+      mask = recorder.hash_size - 1;
+      for (i = 0; i < old_size; i++)
+	if (old[i].oop)
+	  {
+	    size_t j = scramble (OOP_INDEX (old[i].oop)) & mask;
+	    while (recorder.hash[j].oop)
+	      j = (j + 1) & mask;
+	    recorder.hash[j] = old[i];
+	  }
+
+      xfree (old);
+    }
+
+  mask = recorder.hash_size - 1;
+  for (i = scramble (OOP_INDEX (oop)) & mask; recorder.hash[i].oop;
+       i = (i + 1) & mask);
+
+  recorder.hash[i].oop = oop;
+  recorder.hash[i].index = n;
+}
+
+OOP
+global_at (OOP environmentOOP,
+	   OOP nameOOP)
+{
+  OOP assocOOP;
+
+  if (IS_NIL (environmentOOP))
+    {
+      gst_namespace smalltalk =
+	(gst_namespace) OOP_TO_OBJ (_gst_smalltalk_dictionary);
+      if (nameOOP == smalltalk->name)
+	return (_gst_smalltalk_dictionary);
+
+      environmentOOP = _gst_smalltalk_dictionary;
+    }
+
+  if (!IS_OOP (environmentOOP)
+      || !is_a_kind_of (OOP_CLASS (environmentOOP),
+			_gst_abstract_namespace_class))
+    return (_gst_nil_oop);
+
+  assocOOP = dictionary_association_at (environmentOOP, nameOOP);
+  return IS_NIL (assocOOP) ? _gst_nil_oop : ASSOCIATION_VALUE (assocOOP);
+}
+
+void
+write_ref (OOP oop)
+{
+  OOP classOOP;
+  intptr_t index;
+
+  if (recorder.failed)
+    return;
+
+  if (IS_INT (oop))
+    {
+      put_byte (TAG_SMALLINTEGER);
+      put_bytes (&oop, sizeof (OOP));
+      return;
+    }
+
+  if (IS_NIL (oop))
+    {
+      put_byte (TAG_NIL);
+      return;
+    }
+
+  if (oop == _gst_true_oop || oop == _gst_false_oop)
+    {
+      put_byte (oop == _gst_true_oop ? TAG_TRUE : TAG_FALSE);
+      return;
+    }
+
+  if (oop >= CHAR_OOP_AT (0) && oop < CHAR_OOP_AT (NUM_CHAR_OBJECTS))
+    {
+      put_byte (TAG_CHARACTER);
+      put_byte (CHAR_OOP_VALUE (oop));
+      return;
+    }
+
+  index = lookup_object (oop);
+  if (index != -1)
+    {
+      put_byte (TAG_BACKREF);
+      put_count (index);
+      return;
+    }
+
+  classOOP = OOP_CLASS (oop);
+  if (classOOP == _gst_symbol_class)
+    {
+      size_t len = NUM_INDEXABLE_FIELDS (oop);
+      put_byte (TAG_SYMBOL);
+      put_count (len);
+      put_bytes (OOP_TO_OBJ (oop)->data, len);
+      add_object (oop);
+    }
+
+  else if (classOOP == _gst_metaclass_class)
+    {
+      put_byte (TAG_METACLASS);
+      write_ref (METACLASS_INSTANCE (oop));
+      write_shape (oop);
+      add_object (oop);
+    }
+
+  else if (is_a_kind_of (classOOP, _gst_class_class)
+	   || is_a_kind_of (classOOP, _gst_abstract_namespace_class))
+    write_global (oop);
+
+  else if (classOOP == _gst_variable_binding_class)
+    write_binding (oop);
+
+  else
+    write_object (oop);
+}
+
+void
+write_global (OOP oop)
+{
+  OOP environmentOOP, nameOOP;
+
+  if (is_a_kind_of (OOP_CLASS (oop), _gst_abstract_namespace_class))
+    {
+      gst_namespace ns = (gst_namespace) OOP_TO_OBJ (oop);
+      environmentOOP = ns->superspace;
+      nameOOP = ns->name;
+    }
+  else
+    {
+      gst_class class = (gst_class) OOP_TO_OBJ (oop);
+      environmentOOP = class->environment;
+      nameOOP = class->name;
+    }
+
+  /* Anonymous classes and namespaces cannot be found again.  */
+  if (!IS_OOP (nameOOP)
+      || OOP_CLASS (nameOOP) != _gst_symbol_class
+      || global_at (environmentOOP, nameOOP) != oop)
+    {
+      recorder.failed = true;
+      return;
+    }
+
+  put_byte (TAG_GLOBAL);
+  write_ref (environmentOOP);
+  write_ref (nameOOP);
+  if (is_a_kind_of (OOP_CLASS (oop), _gst_class_class))
+    {
+      put_byte (1);
+      write_shape (oop);
+    }
+  else
+    put_byte (0);
+
+  add_object (oop);
+}
+
+void
+write_shape (OOP classOOP)
+{
+  gst_class class = (gst_class) OOP_TO_OBJ (classOOP);
+  intptr_t instanceSpec = class->instanceSpec;
+
+  put_bytes (&instanceSpec, sizeof (instanceSpec));
+  write_ref (class->instanceVariables);
+}
+
+void
+write_binding (OOP oop)
+{
+  gst_variable_binding binding = (gst_variable_binding) OOP_TO_OBJ (oop);
+  OOP keyOOP = binding->key;
+  OOP environmentOOP = binding->environment;
+  OOP classOOP;
+
+  if (!IS_OOP (keyOOP)
+      || OOP_CLASS (keyOOP) != _gst_symbol_class
+      || !IS_OOP (environmentOOP))
+    {
+      write_object (oop);
+      return;
+    }
+
+  if (is_a_kind_of (OOP_CLASS (environmentOOP),
+		    _gst_abstract_namespace_class))
+    {
+      put_byte (TAG_BINDING);
+      write_ref (environmentOOP);
+    }
+  else
+    {
+      /* Class variables live in a BindingDictionary whose environment
+         is the class.  */
+      if (OOP_CLASS (environmentOOP) != _gst_binding_dictionary_class)
+	{
+	  write_object (oop);
+	  return;
+	}
+
+      classOOP =
+	((gst_binding_dictionary) OOP_TO_OBJ (environmentOOP))->environment;
+      if (!IS_OOP (classOOP)
+	  || !is_a_kind_of (OOP_CLASS (classOOP), _gst_class_class)
+	  || _gst_class_variable_dictionary (classOOP) != environmentOOP)
+	{
+	  write_object (oop);
+	  return;
+	}
+
+      put_byte (TAG_POOL_BINDING);
+      write_ref (classOOP);
+    }
+
+  write_ref (keyOOP);
+  add_object (oop);
+}
+
+void
+write_object (OOP oop)
+{
+  OOP classOOP = OOP_CLASS (oop);
+  intptr_t instanceSpec;
+  size_t numFixed, numIndexed, i;
+
+  /* Contexts and C pointers only make sense in this process.  The
+     address of a CCallable is looked up again when it is called.  */
+  if (is_a_kind_of (classOOP, _gst_context_part_class)
+      || is_a_kind_of (classOOP, _gst_behavior_class)
+      || (is_a_kind_of (classOOP, _gst_c_object_class)
+	  && !is_a_kind_of (classOOP, _gst_c_callable_class)))
+    {
+      recorder.failed = true;
+      return;
+    }
+
+  instanceSpec = CLASS_INSTANCE_SPEC (classOOP);
+  numFixed = instanceSpec >> ISP_NUMFIXEDFIELDS;
+  numIndexed = NUM_INDEXABLE_FIELDS (oop);
+
+  /* Number the object first, so that it can refer to itself.  */
+  put_byte (TAG_OBJECT);
+  add_object (oop);
+  write_ref (classOOP);
+  put_byte ((IS_OOP_READONLY (oop) ? OBJECT_READONLY : 0)
+	    | (IS_OOP_UNTRUSTED (oop) ? OBJECT_UNTRUSTED : 0));
+  put_count (numFixed);
+  put_count (numIndexed);
+
+  for (i = 0; i < numFixed; i++)
+    write_ref (OOP_TO_OBJ (oop)->data[i]);
+
+  if ((instanceSpec & ISP_INDEXEDVARS) == GST_ISP_POINTER)
+    for (i = 0; i < numIndexed; i++)
+      write_ref (OOP_TO_OBJ (oop)->data[numFixed + i]);
+  else
+    put_bytes (&OOP_TO_OBJ (oop)->data[numFixed],
+	       numIndexed << _gst_log2_sizes[instanceSpec & ISP_SHAPE]);
+}
+
+
+mst_Boolean
+_gst_precomp_start (void)
+{
+  precomp_header header;
+
+  if (recorder.active)
+    return (false);
+
+  recorder.active = true;
+  recorder.failed = false;
+  recorder.level = 0;
+  recorder.size = 0;
+
+  /* The header is filled in by _gst_precomp_finish.  */
+  memset (&header, 0, sizeof (header));
+  put_bytes (&header, sizeof (header));
+
+  recorder.objects_max = 1024;
+  recorder.objects = (OOP *) xmalloc (recorder.objects_max * sizeof (OOP));
+  recorder.objects_end = recorder.objects;
+  recorder.hash_size = 2 * recorder.objects_max;
+  recorder.hash = (oop_index_entry *)
+    xcalloc (recorder.hash_size, sizeof (oop_index_entry));
+  _gst_register_oop_array (&recorder.objects, &recorder.objects_end);
+  return (true);
+}
+
+OOP
+_gst_precomp_finish (void)
+{
+  precomp_header header;
+  OOP resultOOP = _gst_nil_oop;
+
+  if (!recorder.active)
+    return (_gst_nil_oop);
+
+  if (!recorder.failed)
+    {
+      memset (&header, 0, sizeof (header));
+      memcpy (header.magic, PRECOMP_MAGIC, sizeof (header.magic));
+      header.byte_order = PRECOMP_BYTE_ORDER;
+      header.oop_size = sizeof (OOP);
+      memcpy (header.prim_table_md5, _gst_primitives_md5,
+	      sizeof (header.prim_table_md5));
+      header.num_objects = recorder.objects_end - recorder.objects;
+      memcpy (recorder.buf, &header, sizeof (header));
+      resultOOP = _gst_byte_array_new (recorder.buf, recorder.size);
+    }
+
+  _gst_unregister_oop_array (&recorder.objects);
+  xfree (recorder.objects);
+  xfree (recorder.hash);
+  xfree (recorder.buf);
+  recorder.objects = recorder.objects_end = NULL;
+  recorder.hash = NULL;
+  recorder.buf = NULL;
+  recorder.max = 0;
+  recorder.active = false;
+  recorder.level = 1;
+  return (resultOOP);
+}
+
+int
+_gst_precomp_suspend (void)
+{
+  return recorder.level++;
+}
+
+void
+_gst_precomp_resume (int level)
+{
+  recorder.level = level;
+}
+
+int
+_gst_precomp_send (OOP receiverOOP,
+		   OOP selectorOOP,
+		   OOP *args,
+		   int numArgs)
+{
+  int i;
+
+  watch_event (receiverOOP, NULL);
+  if (is_recording ())
+    {
+      put_byte (PRECOMP_SEND);
+      write_ref (receiverOOP);
+      write_ref (selectorOOP);
+      put_count (numArgs);
+      for (i = 0; i < numArgs; i++)
+	write_ref (args[i]);
+    }
+
+  return _gst_precomp_suspend ();
+}
+
+void
+_gst_precomp_doit (OOP receiverOOP,
+		   OOP methodOOP)
+{
+  watch_event (receiverOOP, methodOOP);
+  if (is_recording ())
+    {
+      put_byte (PRECOMP_DOIT);
+      write_ref (receiverOOP);
+      write_ref (methodOOP);
+    }
+}
+
+void
+_gst_precomp_method (OOP classOOP,
+		     OOP methodOOP)
+{
+  watch_event (classOOP, NULL);
+  if (is_recording ())
+    {
+      put_byte (PRECOMP_METHOD);
+      write_ref (classOOP);
+      write_ref (methodOOP);
+    }
+}
+
+void
+_gst_precomp_class_variable (OOP classOOP,
+			     OOP keyOOP,
+			     OOP valueOOP)
+{
+  watch_event (classOOP, NULL);
+  if (is_recording ())
+    {
+      put_byte (PRECOMP_CLASS_VARIABLE);
+      write_ref (classOOP);
+      write_ref (keyOOP);
+      write_ref (valueOOP);
+    }
+}
+
+void
+_gst_precomp_watch (precomp_watch *w)
+{
+  w->level = recorder.level;
+  w->events = 0;
+  w->receiverOOP = w->methodOOP = NULL;
+  w->prev = watch;
+  watch = w;
+}
+
+void
+_gst_precomp_unwatch (precomp_watch *w)
+{
+  assert (watch == w);
+  watch = w->prev;
+  if (w->methodOOP)
+    {
+      _gst_unregister_oop (w->receiverOOP);
+      _gst_unregister_oop (w->methodOOP);
+    }
+}
+
+
+void
+bad_data (precomp_loader *l)
+{
+  longjmp (l->bad_data, 1);
+}
+
+void
+get_bytes (precomp_loader *l,
+	   PTR dest,
+	   size_t n)
+{
+  if (n > l->size - l->pos)
+    bad_data (l);
+
+  memcpy (dest, ((gst_uchar *) OOP_TO_OBJ (l->bytesOOP)->data) + l->pos, n);
+  l->pos += n;
+}
+
+int
+get_byte (precomp_loader *l)
+{
+  gst_uchar b;
+  get_bytes (l, &b, 1);
+  return b;
+}
+
+size_t
+get_count (precomp_loader *l)
+{
+  uint32_t u;
+  get_bytes (l, &u, sizeof (u));
+  return u;
+}
+
+OOP
+add_loaded (precomp_loader *l,
+	    OOP oop)
+{
+  if (l->count >= l->max)
+    bad_data (l);
+
+  ARRAY_AT_PUT (l->objectsOOP, ++l->count, oop);
+  return (oop);
+}
+
+OOP
+read_ref (precomp_loader *l)
+{
+  OOP oop, nameOOP;
+  size_t index;
+  int tag;
+
+  switch (tag = get_byte (l))
+    {
+    case TAG_SMALLINTEGER:
+      get_bytes (l, &oop, sizeof (OOP));
+      if (!IS_INT (oop))
+	bad_data (l);
+      return (oop);
+
+    case TAG_NIL:
+      return (_gst_nil_oop);
+
+    case TAG_TRUE:
+      return (_gst_true_oop);
+
+    case TAG_FALSE:
+      return (_gst_false_oop);
+
+    case TAG_CHARACTER:
+      return (CHAR_OOP_AT (get_byte (l)));
+
+    case TAG_BACKREF:
+      index = get_count (l);
+      if (index >= l->count)
+	bad_data (l);
+      return (ARRAY_AT (l->objectsOOP, index + 1));
+
+    case TAG_SYMBOL:
+      return add_loaded (l, read_symbol (l));
+
+    case TAG_GLOBAL:
+      oop = read_ref (l);
+      nameOOP = read_ref (l);
+      oop = global_at (oop, nameOOP);
+      if (IS_NIL (oop)
+	  || get_byte (l) != is_a_kind_of (OOP_CLASS (oop), _gst_class_class))
+	bad_data (l);
+      if (is_a_kind_of (OOP_CLASS (oop), _gst_class_class))
+	check_shape (l, oop);
+      return add_loaded (l, oop);
+
+    case TAG_METACLASS:
+      oop = read_ref (l);
+      if (!IS_OOP (oop) || !is_a_kind_of (OOP_CLASS (oop), _gst_class_class))
+	bad_data (l);
+      check_shape (l, OOP_CLASS (oop));
+      return add_loaded (l, OOP_CLASS (oop));
+
+    case TAG_BINDING:
+    case TAG_POOL_BINDING:
+      return add_loaded (l, read_binding (l, tag));
+
+    case TAG_OBJECT:
+      return read_object (l);
+
+    default:
+      bad_data (l);
+    }
+}
+
+OOP
+read_symbol (precomp_loader *l)
+{
+  OOP symbolOOP;
+  size_t len = get_count (l);
+  char *str;
+
+  if (len > l->size - l->pos)
+    bad_data (l);
+
+  str = alloca (len + 1);
+  get_bytes (l, str, len);
+  str[len] = '\0';
+  symbolOOP = _gst_intern_string (str);
+  return (symbolOOP);
+}
+
+void
+check_shape (precomp_loader *l,
+	     OOP classOOP)
+{
+  gst_class class;
+  intptr_t instanceSpec;
+  OOP namesOOP, oldNamesOOP;
+  size_t i, n;
+
+  get_bytes (l, &instanceSpec, sizeof (instanceSpec));
+  namesOOP = read_ref (l);
+
+  /* Reading the names can move the class.  */
+  class = (gst_class) OOP_TO_OBJ (classOOP);
+  oldNamesOOP = class->instanceVariables;
+  if (instanceSpec != class->instanceSpec)
+    bad_data (l);
+
+  if (IS_NIL (namesOOP) || IS_NIL (oldNamesOOP))
+    {
+      if (namesOOP != oldNamesOOP)
+	bad_data (l);
+      return;
+    }
+
+  if (!IS_OOP (namesOOP)
+      || OOP_CLASS (namesOOP) != _gst_array_class
+      || !IS_OOP (oldNamesOOP)
+      || OOP_CLASS (oldNamesOOP) != _gst_array_class)
+    bad_data (l);
+
+  n = NUM_OOPS (OOP_TO_OBJ (namesOOP));
+  if (n != NUM_OOPS (OOP_TO_OBJ (oldNamesOOP)))
+    bad_data (l);
+
+  /* Symbols are unique, so they can be compared by identity.  */
+  for (i = 1; i <= n; i++)
+    if (ARRAY_AT (namesOOP, i) != ARRAY_AT (oldNamesOOP, i))
+      bad_data (l);
+}
+
+OOP
+read_binding (precomp_loader *l,
+	      int tag)
+{
+  OOP ownerOOP, keyOOP, dictionaryOOP, assocOOP;
+
+  ownerOOP = read_ref (l);
+  keyOOP = read_ref (l);
+  if (!IS_OOP (ownerOOP)
+      || !IS_OOP (keyOOP)
+      || OOP_CLASS (keyOOP) != _gst_symbol_class)
+    bad_data (l);
+
+  if (tag == TAG_POOL_BINDING)
+    {
+      if (!is_a_kind_of (OOP_CLASS (ownerOOP), _gst_class_class))
+	bad_data (l);
+      dictionaryOOP = _gst_class_variable_dictionary (ownerOOP);
+      if (IS_NIL (dictionaryOOP))
+	bad_data (l);
+    }
+  else
+    {
+      if (!is_a_kind_of (OOP_CLASS (ownerOOP), _gst_abstract_namespace_class))
+	bad_data (l);
+      dictionaryOOP = ownerOOP;
+    }
+
+  /* A variable that does not exist yet is created, like the compiler
+     would do when it finds an undeclared variable.  */
+  assocOOP = dictionary_association_at (dictionaryOOP, keyOOP);
+  if (IS_NIL (assocOOP))
+    assocOOP = NAMESPACE_AT_PUT (dictionaryOOP, keyOOP, _gst_nil_oop);
+
+  return (assocOOP);
+}
+
+OOP
+read_object (precomp_loader *l)
+{
+  OOP oop, classOOP, fieldOOP;
+  intptr_t instanceSpec;
+  size_t index, numFixed, numIndexed, numBytes, i;
+  mst_Boolean isPointers;
+  int flags;
+
+  /* Number the object first, so that it can refer to itself.  */
+  index = l->count;
+  add_loaded (l, _gst_nil_oop);
+
+  classOOP = read_ref (l);
+  if (!IS_OOP (classOOP)
+      || !is_a_kind_of (OOP_CLASS (classOOP), _gst_class_class))
+    bad_data (l);
+
+  flags = get_byte (l);
+  numFixed = get_count (l);
+  numIndexed = get_count (l);
+
+  /* Check that the class has still the same shape.  Every pointer
+     takes at least one byte, so the size of the object is also
+     bounded by the size of the data.  */
+  instanceSpec = CLASS_INSTANCE_SPEC (classOOP);
+  isPointers = (instanceSpec & ISP_INDEXEDVARS) == GST_ISP_POINTER;
+  numBytes = isPointers ? numIndexed
+    : numIndexed << _gst_log2_sizes[instanceSpec & ISP_SHAPE];
+  if (numFixed != (instanceSpec >> ISP_NUMFIXEDFIELDS)
+      || (numIndexed && !(instanceSpec & ISP_ISINDEXABLE))
+      || numBytes > l->size - l->pos)
+    bad_data (l);
+
+  instantiate_with (classOOP, numIndexed, &oop);
+  ARRAY_AT_PUT (l->objectsOOP, index + 1, oop);
+
+  for (i = 0; i < numFixed; i++)
+    {
+      fieldOOP = read_ref (l);
+      OOP_TO_OBJ (oop)->data[i] = fieldOOP;
+    }
+
+  if (isPointers)
+    for (i = 0; i < numIndexed; i++)
+      {
+        fieldOOP = read_ref (l);
+        OOP_TO_OBJ (oop)->data[numFixed + i] = fieldOOP;
+      }
+  else
+    get_bytes (l, &OOP_TO_OBJ (oop)->data[numFixed], numBytes);
+
+  if (is_a_kind_of (classOOP, _gst_c_callable_class))
+    set_cobject_value (oop, NULL);
+
+  MAKE_OOP_READONLY (oop, flags & OBJECT_READONLY);
+  MAKE_OOP_UNTRUSTED (oop, flags & OBJECT_UNTRUSTED);
+
+  /* Hashed collections, weak objects and the like have to be sent
+     #postLoad.  Do not bother for the common kinds of literal.  */
+  if ((isPointers || !(instanceSpec & ISP_ISINDEXABLE))
+      && classOOP != _gst_array_class
+      && classOOP != _gst_method_info_class
+      && classOOP != _gst_block_closure_class)
+    {
+      if (l->post_load_size == l->post_load_max)
+	{
+	  l->post_load_max = MAX (16, l->post_load_max * 2);
+	  l->post_load = (OOP *)
+	    xrealloc (l->post_load, l->post_load_max * sizeof (OOP));
+	}
+      l->post_load[l->post_load_size++] = oop;
+    }
+
+  return (oop);
+}
+
+
+intptr_t
+_gst_precomp_check (OOP bytesOOP,
+		    size_t *pos)
+{
+  precomp_header header;
+
+  if (NUM_INDEXABLE_FIELDS (bytesOOP) < sizeof (header))
+    return (-1);
+
+  memcpy (&header, OOP_TO_OBJ (bytesOOP)->data, sizeof (header));
+  if (memcmp (header.magic, PRECOMP_MAGIC, sizeof (header.magic))
+      || header.byte_order != PRECOMP_BYTE_ORDER
+      || header.oop_size != sizeof (OOP)
+      || memcmp (header.prim_table_md5, _gst_primitives_md5,
+		 sizeof (header.prim_table_md5)))
+    return (-1);
+
+  *pos = sizeof (header);
+  return (header.num_objects);
+}
+
+OOP
+_gst_precomp_next_event (OOP bytesOOP,
+			 size_t *pos,
+			 OOP objectsOOP,
+			 size_t *count)
+{
+  precomp_loader l;
+  OOP eventOOP, postLoadOOP, argsOOP, oop;
+  OOP operands[3];
+  size_t i, numArgs;
+  int kind;
+  inc_ptr incPtr;
+
+  l.bytesOOP = bytesOOP;
+  l.pos = *pos;
+  l.size = NUM_INDEXABLE_FIELDS (bytesOOP);
+  l.objectsOOP = objectsOOP;
+  l.count = *count;
+  l.max = NUM_INDEXABLE_FIELDS (objectsOOP);
+  l.post_load = NULL;
+  l.post_load_size = l.post_load_max = 0;
+
+  if (l.pos >= l.size)
+    return (_gst_nil_oop);
+
+  incPtr = INC_SAVE_POINTER ();
+  if (setjmp (l.bad_data) != 0)
+    {
+      INC_RESTORE_POINTER (incPtr);
+      xfree (l.post_load);
+      return (NULL);
+    }
+
+  operands[0] = operands[1] = operands[2] = _gst_nil_oop;
+  switch (kind = get_byte (&l))
+    {
+    case PRECOMP_SEND:
+      operands[0] = read_ref (&l);
+      operands[1] = read_ref (&l);
+      numArgs = get_count (&l);
+      if (numArgs > l.size - l.pos)
+	bad_data (&l);
+
+      instantiate_with (_gst_array_class, numArgs, &argsOOP);
+      INC_ADD_OOP (argsOOP);
+      for (i = 0; i < numArgs; i++)
+	{
+	  oop = read_ref (&l);
+	  ARRAY_AT_PUT (argsOOP, i + 1, oop);
+	}
+      operands[2] = argsOOP;
+      break;
+
+    case PRECOMP_DOIT:
+    case PRECOMP_METHOD:
+      operands[0] = read_ref (&l);
+      operands[1] = read_ref (&l);
+      break;
+
+    case PRECOMP_CLASS_VARIABLE:
+      operands[0] = read_ref (&l);
+      operands[1] = read_ref (&l);
+      operands[2] = read_ref (&l);
+      break;
+
+    default:
+      bad_data (&l);
+    }
+
+  instantiate_with (_gst_array_class, l.post_load_size, &postLoadOOP);
+  memcpy (OOP_TO_OBJ (postLoadOOP)->data, l.post_load,
+	  l.post_load_size * sizeof (OOP));
+  xfree (l.post_load);
+  INC_ADD_OOP (postLoadOOP);
+
+  instantiate_with (_gst_array_class, 7, &eventOOP);
+  ARRAY_AT_PUT (eventOOP, 1, FROM_INT (kind));
+  ARRAY_AT_PUT (eventOOP, 2, operands[0]);
+  ARRAY_AT_PUT (eventOOP, 3, operands[1]);
+  ARRAY_AT_PUT (eventOOP, 4, operands[2]);
+  ARRAY_AT_PUT (eventOOP, 5, postLoadOOP);
+  ARRAY_AT_PUT (eventOOP, 6, FROM_INT (l.pos));
+  ARRAY_AT_PUT (eventOOP, 7, FROM_INT (l.count));
+
+  INC_RESTORE_POINTER (incPtr);
+  *pos = l.pos;
+  *count = l.count;
+  return (eventOOP);
+}
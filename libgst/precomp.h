@@ -0,0 +1,167 @@
+/******************************** -*- C -*- ****************************
+ *
+ *	Precompiled package definitions
+ *
+ *
+ ***********************************************************************/
+
+/***********************************************************************
+ *
+ * Copyright 2026 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Smalltalk.
+ *
+ * GNU Smalltalk is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any later 
+ * version.
+ * 
+ * Linking GNU Smalltalk statically or dynamically with other modules is
+ * making a combined work based on GNU Smalltalk.  Thus, the terms and
+ * conditions of the GNU General Public License cover the whole
+ * combination.
+ *
+ * In addition, as a special exception, the Free Software Foundation
+ * give you permission to combine GNU Smalltalk with free software
+ * programs or libraries that are released under the GNU LGPL and with
+ * independent programs running under the GNU Smalltalk virtual machine.
+ *
+ * You may copy and distribute such a system following the terms of the
+ * GNU GPL for GNU Smalltalk and the licenses of the other code
+ * concerned, provided that you include the source code of that other
+ * code when and as the GNU GPL requires distribution of source code.
+ *
+ * Note that people who make modified versions of GNU Smalltalk are not
+ * obligated to grant this special exception for their modified
+ * versions; it is their choice whether to do so.  The GNU General
+ * Public License gives permission to release a modified version without
+ * this exception; this exception also makes it possible to release a
+ * modified version which carries forward this exception.
+ *
+ * GNU Smalltalk is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * GNU Smalltalk; see the file COPYING.  If not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.  
+ *
+ ***********************************************************************/
+
+
+#ifndef GST_PRECOMP_H
+#define GST_PRECOMP_H
+
+/* A precompiled package is a recording of what the parser did while
+   filing in the package's sources: the messages it sent to create
+   namespaces and classes, the doits it executed, the class variables
+   it initialized and the methods it installed.  Objects are stored
+   by value, except for symbols, classes, namespaces and variable
+   bindings which are stored by name and looked up again when the
+   package is loaded.  Loading the recording (see PrecompiledPackage
+   in kernel/PkgLoader.st) replays the same actions without lexing,
+   parsing or compiling anything.  */
+
+/* The kinds of event that are found in a precompiled package.  */
+enum precomp_event {
+  PRECOMP_SEND = 1,
+  PRECOMP_DOIT,
+  PRECOMP_METHOD,
+  PRECOMP_CLASS_VARIABLE
+};
+
+/* The events counted by _gst_precomp_watch.  The receiver and method
+   of the first doit are kept (and registered with the garbage
+   collector) until _gst_precomp_unwatch.  */
+typedef struct precomp_watch
+{
+  int level;
+  int events;
+  OOP receiverOOP;
+  OOP methodOOP;
+  struct precomp_watch *prev;
+} precomp_watch;
+
+/* Start recording the actions of the parser.  Answer false if a
+   recording is already in progress.  */
+extern mst_Boolean _gst_precomp_start (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Stop recording and answer a ByteArray with the precompiled package,
+   or nil if something was recorded that cannot be stored in a
+   precompiled package (such as a context or a C pointer).  */
+extern OOP _gst_precomp_finish (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Stop recording the actions of the parser until the matching
+   _gst_precomp_resume, for example while the code that they run
+   executes; answer a value to be passed to _gst_precomp_resume.  */
+extern int _gst_precomp_suspend (void)
+  ATTRIBUTE_HIDDEN;
+
+/* Undo the effect of the _gst_precomp_suspend call that answered
+   LEVEL.  */
+extern void _gst_precomp_resume (int level)
+  ATTRIBUTE_HIDDEN;
+
+/* Record that the parser is sending SELECTOROOP to RECEIVEROOP, with
+   the NUMARGS arguments in ARGS, and suspend recording like
+   _gst_precomp_suspend until the message returns.  */
+extern int _gst_precomp_send (OOP receiverOOP,
+			      OOP selectorOOP,
+			      OOP *args,
+			      int numArgs)
+  ATTRIBUTE_HIDDEN;
+
+/* Record that the doit METHODOOP was executed with RECEIVEROOP as
+   the receiver.  */
+extern void _gst_precomp_doit (OOP receiverOOP,
+			       OOP methodOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Record that METHODOOP was compiled and installed in CLASSOOP.  */
+extern void _gst_precomp_method (OOP classOOP,
+				 OOP methodOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Record that the class variable KEYOOP of CLASSOOP was initialized
+   to VALUEOOP by a class body.  */
+extern void _gst_precomp_class_variable (OOP classOOP,
+					 OOP keyOOP,
+					 OOP valueOOP)
+  ATTRIBUTE_HIDDEN;
+
+/* Start counting in WATCH the events that the parser generates at
+   the current level, for example to find out whether evaluating a
+   string did anything but executing a doit.  Watches can be nested.  */
+extern void _gst_precomp_watch (precomp_watch *watch)
+  ATTRIBUTE_HIDDEN;
+
+/* Stop counting the events in WATCH, which must be the innermost
+   watch.  */
+extern void _gst_precomp_unwatch (precomp_watch *watch)
+  ATTRIBUTE_HIDDEN;
+
+/* Check the header of the precompiled package in BYTESOOP and answer
+   how many objects are stored in it, storing in *POS the offset of
+   the first event.  Answer -1 if the precompiled package was written
+   by a different virtual machine.  */
+extern intptr_t _gst_precomp_check (OOP bytesOOP,
+				    size_t *pos)
+  ATTRIBUTE_HIDDEN;
+
+/* Decode the event at offset *POS of the precompiled package in
+   BYTESOOP, using the OBJECTSOOP Array (whose first *COUNT elements
+   are already filled) to store the objects that are loaded.  Answer
+   an Array with the kind of event, its three operands, the objects
+   that need to be sent #postLoad and the updated values of *POS and
+   *COUNT; answer nil at the end of the package, and NULL if the data
+   is invalid or refers to a class or namespace that does not exist.  */
+extern OOP _gst_precomp_next_event (OOP bytesOOP,
+				    size_t *pos,
+				    OOP objectsOOP,
+				    size_t *count)
+  ATTRIBUTE_HIDDEN;
+
+#endif /* GST_PRECOMP_H */
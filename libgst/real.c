@@ -92,6 +92,21 @@ static void do_mul (struct real *r, struct real *s, int lsb);
    or S, but R must not be the same as S.  R is destroyed  */
 static void do_div (struct real *out, struct real *r, struct real *s);
 
+/* Store into DIGITS the first PRECISION significant digits of D,
+   correctly rounded, and answer the decimal exponent of the result
+   (see _gst_shortest_digits).  */
+static int format_digits (double d, int precision, char *digits);
+
+/* Answer the float or double (according to IS_FLOAT) nearest to
+   0.DIGITS * 10^EXPONENT.  */
+static double digits_value (const char *digits, int exponent,
+			    mst_Boolean is_float);
+
+/* Add DELTA (either 1 or -1) to the last digit of DIGITS, which is
+   written with exponent *PEXPONENT, without changing the number
+   of digits.  */
+static void adjust_digits (char *digits, int *pExponent, int delta);
+
 /* These routines are not optimized at all.  Maybe I should have bit
    the bullet and required MPFR after all...  */
 
@@ -531,3 +546,112 @@ _gst_real_get_ld (struct real *r)
   result = ldexpl (result, r->exp - NUM_SIG_BITS + 1);
   return r->sign == -1 ? -result : result;
 }
+
+
+int
+format_digits (double d, int precision, char *digits)
+{
+  char buf[40], *p;
+
+  /* The result is d.ddde[+-]xx, where the decimal point depends on
+     LC_NUMERIC; only the digits and the exponent are looked at.  */
+  sprintf (buf, "%.*e", precision - 1, d);
+  for (p = buf; *p != 'e'; p++)
+    if (*p >= '0' && *p <= '9')
+      *digits++ = *p;
+
+  *digits = '\0';
+  return atoi (p + 1) + 1;
+}
+
+double
+digits_value (const char *digits, int exponent, mst_Boolean is_float)
+{
+  char buf[40];
+
+  /* 0.ddd * 10^exponent is written as an integer mantissa, so that
+     the decimal point of the current locale does not matter.  */
+  sprintf (buf, "%se%d", digits, exponent - (int) strlen (digits));
+  return is_float ? (double) strtof (buf, NULL) : strtod (buf, NULL);
+}
+
+void
+adjust_digits (char *digits, int *pExponent, int delta)
+{
+  int n = strlen (digits);
+  char *p;
+
+  for (p = digits + n - 1; p >= digits; p--)
+    {
+      if (delta > 0 ? *p < '9' : *p > '0')
+	{
+	  *p += delta;
+	  break;
+	}
+
+      *p = delta > 0 ? '0' : '9';
+    }
+
+  /* 999 + 1 = 1000, which has one digit more: use 100 and
+     increase the exponent.  */
+  if (p < digits)
+    {
+      digits[0] = '1';
+      (*pExponent)++;
+    }
+
+  /* 100 - 1 = 099, which has one digit less: use 999 and
+     decrease the exponent.  */
+  else if (digits[0] == '0')
+    {
+      memset (digits, '9', n);
+      (*pExponent)--;
+    }
+}
+
+int
+_gst_shortest_digits (double d, mst_Boolean is_float, char *digits)
+{
+  int precision, minPrecision, maxPrecision, exponent, n;
+  double back;
+
+  d = fabs (d);
+
+  /* Every decimal number with at most FLT_DIG or DBL_DIG digits is
+     recovered by rounding the nearest normalized float or double to
+     that many digits, so shorter strings need not be tried.  This
+     does not hold for denormals, which have less precision.  */
+  if (is_float)
+    {
+      minPrecision = d < FLT_MIN ? 1 : FLT_DIG;
+      maxPrecision = 9;
+    }
+  else
+    {
+      minPrecision = d < DBL_MIN ? 1 : DBL_DIG;
+      maxPrecision = 17;
+    }
+
+  for (precision = minPrecision; precision < maxPrecision; precision++)
+    {
+      exponent = format_digits (d, precision, digits);
+      back = digits_value (digits, exponent, is_float);
+      if (back == d)
+	goto found;
+
+      /* The nearest string of PRECISION digits does not read back
+	 as D, but the one on the other side of D might, because
+	 floats are more widely spaced above powers of two.  */
+      adjust_digits (digits, &exponent, back > d ? -1 : 1);
+      if (digits_value (digits, exponent, is_float) == d)
+	goto found;
+    }
+
+  /* This many digits are always enough.  */
+  exponent = format_digits (d, maxPrecision, digits);
+
+ found:
+  for (n = strlen (digits); n > 1 && digits[n - 1] == '0'; n--);
+  digits[n] = '\0';
+  return exponent;
+}
@@ -102,4 +102,14 @@ extern void _gst_real_inv (struct real *out, struct real *r)
 extern long double _gst_real_get_ld (struct real *r)
   ATTRIBUTE_HIDDEN;
 
+/* Store into DIGITS the shortest string of decimal digits that reads
+   back as the finite, nonzero number D (rounded to a float if IS_FLOAT
+   is true), and answer the decimal exponent E such that D is
+   0.DIGITS * 10^E.  If more strings have the same length, the one
+   nearest to D is chosen.  DIGITS must have room for 18 bytes.  */
+extern int _gst_shortest_digits (double d,
+				 mst_Boolean is_float,
+				 char *digits)
+  ATTRIBUTE_HIDDEN;
+
 #endif
@@ -55,13 +55,28 @@
 #include "gstpriv.h"
 #include "pointer-set.h"
 
+/* The symbol table is an Array.  Its first slot holds the number of
+   Symbols in it, and it is followed by a power-of-two number of
+   buckets, each made of a Symbol (or nil) and its hash value.
+   Collisions are resolved by linear probing.  */
+typedef struct symbol_bucket
+{
+  OOP symbol;
+  OOP hash;
+}
+symbol_bucket;
+
 typedef struct
 {
   OBJ_HEADER;
-  OOP nextLink;
-  OOP symbol;
+  OOP tally;
+  symbol_bucket buckets[1];
 }
- *sym_link;
+ *gst_symbol_table;
+
+/* Answer the number of buckets in the symbol table TABLE.  */
+#define SYMBOL_TABLE_BUCKETS(table) \
+  ((NUM_WORDS (table) - 1) / 2)
 
 typedef struct symbol_list *symbol_list;
 
@@ -189,9 +204,16 @@ static mst_Boolean is_same_string (const char *str,
    upon image loading, when the classes have not been initialized yet.  */
 static OOP alloc_symbol_oop (const char *str, int len);
 
-/* Link SYMBOLOOP into the symbol table (using the given hash table index),
-   and fill the class slot of the symbol.  */
-static OOP alloc_symlink (OOP symbolOOP, uintptr_t index);
+/* Answer the hash value of the symbol whose LEN characters start
+   at STR.  */
+static uintptr_t hash_symbol (const char *str, int len);
+
+/* Add SYMBOLOOP, whose hash value is HASH, to the symbol table, growing
+   it if needed, and fill the class slot of the symbol.  */
+static OOP add_symbol (OOP symbolOOP, uintptr_t hash);
+
+/* Double the number of buckets in the symbol table.  */
+static void grow_symbol_table (void);
 
 /* Answer whether C is considered a white space character in Smalltalk
    programs.  */
@@ -262,6 +284,14 @@ static symbol_list find_local_var (scope scope,
    the symbol list for the variable if it is found.  */
 static OOP find_class_variable (OOP varName);
 
+/* Add after P_END the pools that a method of MYCLASS looks up
+   variables in; ENVIRONMENTOOP replaces the environment of each
+   class if FORDOIT is true.  Return the new end of the list.  */
+static pool_list *add_linearized_pools (OOP myClass,
+					OOP environmentOOP,
+					mst_Boolean forDoit,
+					pool_list *p_end);
+
 /* This is an array of symbols which the virtual machine knows about,
    and is used to restore the global variables upon image load.  */
 static const symbol_info sym_info[] = {
@@ -387,14 +417,20 @@ _gst_pop_all_scopes (void)
 
 void
 _gst_free_linearized_pools ()
+{
+  _gst_free_pool_list (_gst_current_parser->linearized_pools);
+  _gst_current_parser->linearized_pools = NULL;
+}
+
+void
+_gst_free_pool_list (pool_list pools)
 {
   pool_list next;
 
-  while (_gst_current_parser->linearized_pools)
+  for (; pools; pools = next)
     {
-      next = _gst_current_parser->linearized_pools->next;
-      xfree (_gst_current_parser->linearized_pools);
-      _gst_current_parser->linearized_pools = next;
+      next = pools->next;
+      xfree (pools);
     }
 }
 
@@ -835,9 +871,7 @@ add_shared_pool_resolution (OOP class_oop, OOP environmentOOP, pool_list *p_end)
 void
 _gst_compute_linearized_pools (gst_parser *parser, mst_Boolean forDoit)
 {
-  pool_list *p_end = &_gst_current_parser->linearized_pools;
-  OOP myClass, classOOP;
-  OOP environmentOOP = parser->current_namespace;
+  OOP myClass;
 
   if (IS_NIL (parser->currentClass))
     myClass = _gst_undefined_object_class;
@@ -845,6 +879,43 @@ _gst_compute_linearized_pools (gst_parser *parser, mst_Boolean forDoit)
     myClass = _gst_get_class_object (parser->currentClass);
 
   assert (_gst_current_parser->linearized_pools == NULL);
+  add_linearized_pools (myClass, parser->current_namespace, forDoit,
+			&_gst_current_parser->linearized_pools);
+}
+
+pool_list
+_gst_make_pool_list (OOP classOOP,
+		     OOP environmentOOP,
+		     mst_Boolean forDoit)
+{
+  pool_list pools = NULL;
+  add_linearized_pools (classOOP, environmentOOP, forDoit, &pools);
+  return (pools);
+}
+
+OOP
+_gst_pool_list_association_at (pool_list pools,
+			       OOP varName)
+{
+  OOP assocOOP;
+
+  for (; pools; pools = pools->next)
+    {
+      assocOOP = dictionary_association_at (pools->poolOOP, varName);
+      if (!IS_NIL (assocOOP))
+	return (assocOOP);
+    }
+
+  return (_gst_nil_oop);
+}
+
+pool_list *
+add_linearized_pools (OOP myClass,
+		      OOP environmentOOP,
+		      mst_Boolean forDoit,
+		      pool_list *p_end)
+{
+  OOP classOOP;
 
   /* Add pools separately for each class.  */
   for (classOOP = myClass; !IS_NIL (classOOP); classOOP = SUPERCLASS (classOOP))
@@ -859,24 +930,15 @@ _gst_compute_linearized_pools (gst_parser *parser, mst_Boolean forDoit)
 	       forDoit ? environmentOOP : CLASS_ENVIRONMENT (classOOP),
 	       p_end);
     }
+
+  return (p_end);
 }
 
 OOP
 find_class_variable (OOP varName)
 {
-  pool_list pool;
-  OOP assocOOP;
-
-  for (pool = _gst_current_parser->linearized_pools; pool; pool = pool->next)
-    {
-      assocOOP =
-	dictionary_association_at (pool->poolOOP, varName);
-
-      if (!IS_NIL (assocOOP))
-	return (assocOOP);
-    }
-
-  return (_gst_nil_oop);
+  return (_gst_pool_list_association_at
+	  (_gst_current_parser->linearized_pools, varName));
 }
 
 
@@ -1393,28 +1455,69 @@ _gst_intern_string (const char *str)
   return (intern_counted_string (str, len));
 }
 
-static uintptr_t
+uintptr_t
 hash_symbol (const char *str, int len)
 {
-  uintptr_t index = scramble (_gst_hash_string (str, len));
-  return (index & (SYMBOL_TABLE_SIZE - 1)) + 1;
+  return scramble (_gst_hash_string (str, len));
 }
 
-static OOP
-alloc_symlink (OOP symbolOOP, uintptr_t index)
+void
+grow_symbol_table (void)
+{
+  gst_symbol_table oldTable, newTable;
+  OOP newTableOOP;
+  uintptr_t i, j, oldBuckets, mask;
+
+  oldBuckets = SYMBOL_TABLE_BUCKETS (OOP_TO_OBJ (_gst_symbol_table));
+  mask = oldBuckets * 2 - 1;
+  newTable = (gst_symbol_table)
+    instantiate_with (_gst_array_class, oldBuckets * 4 + 1, &newTableOOP);
+
+  /* Reinsert the symbols using the cached hash values.  */
+  oldTable = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+  newTable->tally = oldTable->tally;
+  for (i = 0; i < oldBuckets; i++)
+    {
+      if (IS_NIL (oldTable->buckets[i].symbol))
+	continue;
+
+      for (j = TO_INT (oldTable->buckets[i].hash) & mask;
+	   !IS_NIL (newTable->buckets[j].symbol); j = (j + 1) & mask);
+
+      newTable->buckets[j] = oldTable->buckets[i];
+    }
+
+  /* Keep the same OOP, which is known to the image.  */
+  _gst_swap_objects (_gst_symbol_table, newTableOOP);
+}
+
+OOP
+add_symbol (OOP symbolOOP, uintptr_t hash)
 {
   gst_symbol symbol;
-  sym_link link;
-  OOP linkOOP;
+  gst_symbol_table table;
+  uintptr_t i, numBuckets, mask;
 
   symbol = (gst_symbol) OOP_TO_OBJ (symbolOOP);
   symbol->objClass = _gst_symbol_class;
 
-  link = (sym_link) new_instance (_gst_sym_link_class, &linkOOP);
-  link->nextLink = ARRAY_AT (_gst_symbol_table, index);
-  link->symbol = symbolOOP;
-  ARRAY_AT_PUT (_gst_symbol_table, index, linkOOP);
+  /* Keep the table at most three quarters full, so that the chains
+     of colliding symbols stay short.  */
+  table = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+  numBuckets = SYMBOL_TABLE_BUCKETS (table);
+  if ((TO_INT (table->tally) + 1) * 4 > numBuckets * 3)
+    {
+      grow_symbol_table ();
+      table = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+      numBuckets = SYMBOL_TABLE_BUCKETS (table);
+    }
+
+  mask = numBuckets - 1;
+  for (i = hash & mask; !IS_NIL (table->buckets[i].symbol); i = (i + 1) & mask);
 
+  table->buckets[i].symbol = symbolOOP;
+  table->buckets[i].hash = FROM_INT (hash);
+  table->tally = INCR_INT (table->tally);
   return (symbolOOP);
 }
 
@@ -1422,21 +1525,21 @@ static OOP
 intern_counted_string (const char *str,
 		       int len)
 {
-  uintptr_t index;
-  OOP symbolOOP, linkOOP;
-  sym_link link;
+  uintptr_t hash, i, mask;
+  OOP symbolOOP, hashOOP;
+  gst_symbol_table table;
   inc_ptr incPtr;
 
-  index = hash_symbol (str, len);
-  for (linkOOP = ARRAY_AT (_gst_symbol_table, index); !IS_NIL (linkOOP);
-       linkOOP = link->nextLink)
-    {
-      link = (sym_link) OOP_TO_OBJ (linkOOP);
-      if (is_same_string (str, link->symbol, len))
-	return (link->symbol);
-    }
+  hash = hash_symbol (str, len);
+  hashOOP = FROM_INT (hash);
+  table = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+  mask = SYMBOL_TABLE_BUCKETS (table) - 1;
+  for (i = hash & mask; !IS_NIL (table->buckets[i].symbol); i = (i + 1) & mask)
+    if (table->buckets[i].hash == hashOOP
+	&& is_same_string (str, table->buckets[i].symbol, len))
+      return (table->buckets[i].symbol);
 
-  /* no match, have to add it to head of list */
+  /* no match, have to add it */
 #ifdef HAVE_READLINE
   _gst_add_symbol_completion (str, len);
 #endif
@@ -1445,7 +1548,7 @@ intern_counted_string (const char *str,
   symbolOOP = alloc_symbol_oop (str, len);
   INC_ADD_OOP (symbolOOP);
 
-  alloc_symlink (symbolOOP, index);
+  add_symbol (symbolOOP, hash);
   INC_RESTORE_POINTER (incPtr);
 
   return (symbolOOP);
@@ -1507,47 +1610,60 @@ _gst_hash_string (const char *str,
 void
 _gst_check_symbol_chain (void)
 {
-  int i;
+  gst_symbol_table table;
+  uintptr_t i, numBuckets;
+  OOP symbolOOP;
+  int tally = 0;
 
-  for (i = 1; i <= SYMBOL_TABLE_SIZE; i++)
+  table = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+  numBuckets = SYMBOL_TABLE_BUCKETS (table);
+  for (i = 0; i < numBuckets; i++)
     {
-      sym_link link;
-      OOP linkOOP;
-      for (linkOOP = ARRAY_AT (_gst_symbol_table, i); !IS_NIL (linkOOP);
-	   linkOOP = link->nextLink)
+      symbolOOP = table->buckets[i].symbol;
+      if (IS_NIL (symbolOOP))
+	continue;
+
+      tally++;
+      if (OOP_CLASS (symbolOOP) != _gst_symbol_class
+	  || !IS_INT (table->buckets[i].hash))
 	{
-	  link = (sym_link) OOP_TO_OBJ (linkOOP);
-	  if (OOP_CLASS (linkOOP) != _gst_sym_link_class ||
-	      OOP_CLASS (link->symbol) != _gst_symbol_class)
-	    {
-	      printf ("Bad symbol %p\n", linkOOP);
-	      abort ();
-	    }
+	  printf ("Bad symbol %p\n", symbolOOP);
+	  abort ();
 	}
     }
+
+  if (tally != TO_INT (table->tally))
+    {
+      printf ("Bad symbol count %d, should be %d\n",
+	      (int) TO_INT (table->tally), tally);
+      abort ();
+    }
 }
 
 #ifdef HAVE_READLINE
 void
 _gst_add_all_symbol_completions (void)
 {
-  int i;
+  uintptr_t i;
 
-  for (i = 1; i <= SYMBOL_TABLE_SIZE; i++)
+  for (i = 0;
+       i < SYMBOL_TABLE_BUCKETS (OOP_TO_OBJ (_gst_symbol_table)); i++)
     {
-      sym_link link;
-      OOP linkOOP;
+      gst_symbol_table table;
+      OOP symbolOOP;
       char *string;
       int len;
-      for (linkOOP = ARRAY_AT (_gst_symbol_table, i); !IS_NIL (linkOOP);
-	   linkOOP = link->nextLink)
-	{
-	  link = (sym_link) OOP_TO_OBJ (linkOOP);
-	  string = _gst_to_cstring (link->symbol);
-	  len = _gst_string_oop_len (link->symbol);
-	  _gst_add_symbol_completion (string, len);
-	  xfree (string);
-	}
+
+      /* Reload the table, because _gst_to_cstring allocates memory.  */
+      table = (gst_symbol_table) OOP_TO_OBJ (_gst_symbol_table);
+      symbolOOP = table->buckets[i].symbol;
+      if (IS_NIL (symbolOOP))
+	continue;
+
+      string = _gst_to_cstring (symbolOOP);
+      len = _gst_string_oop_len (symbolOOP);
+      _gst_add_symbol_completion (string, len);
+      xfree (string);
     }
 }
 #endif
@@ -1609,7 +1725,7 @@ _gst_init_symbols_pass2 (void)
   struct builtin_selector *bs;
 
   for (si = sym_info; si->symbolVar; si++)
-    alloc_symlink (*si->symbolVar, hash_symbol (si->value, strlen (si->value)));
+    add_symbol (*si->symbolVar, hash_symbol (si->value, strlen (si->value)));
 
   /* Complete gperf's generated table with each symbol's OOP,
      and prepare a kind of reverse mapping from the 256 bytecodes
@@ -1621,7 +1737,7 @@ _gst_init_symbols_pass2 (void)
     if (bs->offset != -1)
       {
 	const char *name = bs->offset + _gst_builtin_selectors_names;
-	alloc_symlink (bs->symbol, hash_symbol (name, strlen (name)));
+	add_symbol (bs->symbol, hash_symbol (name, strlen (name)));
       }
 }
 
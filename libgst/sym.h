@@ -55,6 +55,8 @@
 #ifndef GST_SYM_H
 #define GST_SYM_H
 
+/* The initial number of buckets in the symbol table; it must be a
+   power of two.  */
 #define SYMBOL_TABLE_SIZE	512
 
 typedef enum
@@ -196,6 +198,24 @@ extern void _gst_compute_linearized_pools (struct gst_parser *parser,
 extern void _gst_free_linearized_pools (void)
   ATTRIBUTE_HIDDEN;
 
+/* Answer the pools where a method of CLASSOOP looks up variables, in
+   order.  If FORDOIT is true, use ENVIRONMENTOOP instead of the
+   environment of each class, like _gst_compute_linearized_pools.  */
+extern pool_list _gst_make_pool_list (OOP classOOP,
+				      OOP environmentOOP,
+				      mst_Boolean forDoit)
+  ATTRIBUTE_HIDDEN;
+
+/* Answer the association for VARNAME in the first of POOLS that
+   has one, or nil.  */
+extern OOP _gst_pool_list_association_at (pool_list pools,
+					  OOP varName)
+  ATTRIBUTE_HIDDEN;
+
+/* Free the list POOLS.  */
+extern void _gst_free_pool_list (pool_list pools)
+  ATTRIBUTE_HIDDEN;
+
 /* This converts a C string to a symbol and stores it in the symbol
    table.  */
 extern OOP _gst_intern_string (const char *str)
@@ -345,8 +365,8 @@ extern void _gst_print_symbols (void)
 extern void _gst_init_symbols_pass1 (void)
   ATTRIBUTE_HIDDEN;
 
-/* This one creates the SymLink OOPs for the Symbols previously
-   created.  */
+/* This one adds the Symbols previously created to the symbol
+   table.  */
 extern void _gst_init_symbols_pass2 (void)
   ATTRIBUTE_HIDDEN;
 
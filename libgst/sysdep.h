@@ -108,6 +108,13 @@ extern void _gst_sigvtalrm_every (int deltaMilli,
 			       SigHandler func)
   ATTRIBUTE_HIDDEN;
 
+/* Establish FUNC to be called every DELTAMICRO microseconds of
+   process time, counting both user and system time, or stop calling
+   it if DELTAMICRO is zero.  */
+extern void _gst_sigprof_every (int deltaMicro,
+				SigHandler func)
+  ATTRIBUTE_HIDDEN;
+
 /* Establish SIGALRM to be called when the nanosecond clock reaches NSTIME
    nanoseconds.  */
 extern void _gst_sigalrm_at (int64_t nsTime)
@@ -240,6 +247,17 @@ extern ssize_t _gst_write (int fd,
 		           size_t size)
   ATTRIBUTE_HIDDEN;
 
+/* Write the COUNT buffers in BUFFERS, whose sizes are in SIZES, into
+   the file descriptor FD with as few system calls as possible.  Like
+   _gst_write, answer the number of bytes written or -1 on error; a
+   short count can be returned even if all the buffers could be
+   written.  */
+extern ssize_t _gst_write_buffers (int fd,
+				   PTR *buffers,
+				   size_t *sizes,
+				   int count)
+  ATTRIBUTE_HIDDEN;
+
 /* Read SIZE bytes into BUFFER from the file descriptor for a socket, FD.  */
 extern ssize_t _gst_recv (int fd,
 		          PTR buffer,
@@ -430,6 +430,62 @@ _gst_write (int fd,
 
   return result;
 }
+
+ssize_t
+_gst_write_buffers (int fd,
+		    PTR *buffers,
+		    size_t *sizes,
+		    int count)
+{
+#if defined HAVE_WRITEV && defined HAVE_SYS_UIO_H
+  struct iovec *iov;
+  ssize_t result;
+  int save_errno = errno;
+  int i;
+
+#ifdef IOV_MAX
+  if (count > IOV_MAX)
+    count = IOV_MAX;
+#endif
+
+  iov = alloca (count * sizeof (struct iovec));
+  for (i = 0; i < count; i++)
+    {
+      iov[i].iov_base = buffers[i];
+      iov[i].iov_len = sizes[i];
+    }
+
+  do
+    {
+      result = writev (fd, iov, count);
+      if (errno == EFAULT)
+        abort ();
+    }
+  while (result == -1 && errno == EINTR);
+  if (errno == EINTR)
+    errno = save_errno;
+
+  return result;
+
+#else
+  ssize_t result, total = 0;
+  int i;
+
+  /* Stop at the first short write, the caller will retry the rest.  */
+  for (i = 0; i < count; i++)
+    {
+      result = _gst_write (fd, buffers[i], sizes[i]);
+      if (result == -1)
+	return total ? total : -1;
+
+      total += result;
+      if ((size_t) result < sizes[i])
+	break;
+    }
+
+  return total;
+#endif
+}
 
 
 void
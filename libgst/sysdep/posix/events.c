@@ -55,6 +55,7 @@
 #include "lock.h"
 
 #include <poll.h>
+#include <sys/socket.h>
 
 #ifdef HAVE_UTIME_H
 # include <utime.h>
@@ -367,7 +368,18 @@ _gst_pause (void)
          not allow that.  */
       sigset_t set;
       sigemptyset (&set);
-      sigsuspend (&set);
+#ifdef HAVE_PPOLL
+      /* Do not rely on SIGIO alone to learn about polled files: a
+	 descriptor that is shared with forked processes only sends it
+	 to the one that registered last.  */
+      if (num_used_pollfds > 0)
+	{
+	  if (ppoll (pollfds, num_used_pollfds, NULL, &set) > 0)
+	    signal_polled_files (-1, true);
+	}
+      else
+#endif
+        sigsuspend (&set);
     }
 #ifdef USE_POSIX_THREADS
   waiting_thread = 0;
@@ -385,6 +397,70 @@ _gst_wakeup (void)
 #endif
 }
 
+int
+_gst_fork (int *fd)
+{
+#ifdef HAVE_FORK
+  polling_queue *node, *next;
+  int sv[2];
+  pid_t pid;
+
+  if (fd && socketpair (AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+    return -1;
+
+  /* Do not let the child write again what is buffered now.  */
+  fflush (NULL);
+  _gst_lex_ahead_before_fork ();
+  pid = fork ();
+  _gst_lex_ahead_after_fork (pid == 0);
+  if (pid == -1)
+    {
+      int save_errno = errno;
+      if (fd)
+	{
+	  close (sv[0]);
+	  close (sv[1]);
+	}
+      errno = save_errno;
+      return -1;
+    }
+
+  if (fd)
+    {
+      close (sv[pid != 0]);
+      *fd = sv[pid == 0];
+    }
+
+  if (pid == 0)
+    {
+      /* Timers are not inherited by the child, and the files that the
+	 parent was polling are none of its business.  */
+      _gst_init_sysdep_timer ();
+      for (node = head; node; node = next)
+	{
+	  next = node->next;
+	  _gst_unregister_oop (node->semaphoreOOP);
+	  xfree (node);
+	}
+
+      head = NULL;
+      p_tail_next = &head;
+      num_used_pollfds = 0;
+#ifdef USE_POSIX_THREADS
+      waiting_thread = 0;
+#endif
+
+      /* Neither are the threads that run call-outs.  */
+      _gst_reset_threaded_croutines ();
+    }
+
+  return pid;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
 int
 _gst_async_file_polling (int fd,
 			 int cond,
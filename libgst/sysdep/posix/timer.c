@@ -77,6 +77,21 @@ _gst_sigvtalrm_every (int deltaMilli,
 #endif
 }
 
+void
+_gst_sigprof_every (int deltaMicro,
+		    SigHandler func)
+{
+#if defined ITIMER_PROF
+  struct itimerval value;
+  _gst_set_signal_handler (SIGPROF, func);
+
+  value.it_interval.tv_sec = deltaMicro / 1000000;
+  value.it_interval.tv_usec = deltaMicro % 1000000;
+  value.it_value = value.it_interval;
+  setitimer (ITIMER_PROF, &value, (struct itimerval *) 0);
+#endif
+}
+
 #ifdef HAVE_TIMER_CREATE
 static timer_t timer;
 static mst_Boolean have_timer;
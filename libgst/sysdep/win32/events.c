@@ -582,6 +582,13 @@ _gst_async_file_polling (int fd,
   return 0;
 }
 
+int
+_gst_fork (int *fd)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
 void
 _gst_wait_for_input (int fd)
 {
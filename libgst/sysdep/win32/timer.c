@@ -68,6 +68,12 @@ _gst_sigvtalrm_every (int deltaMilli)
 {
 }
 
+void
+_gst_sigprof_every (int deltaMicro,
+		    SigHandler func)
+{
+}
+
 void
 _gst_init_sysdep_timer (void)
 {
@@ -53,6 +53,10 @@
 #include "gstpriv.h"
 #include "match.h"
 
+/* Whether to describe translations for perf(1); see PERF_MAP_FILE and
+   PERF_MAP_JITDUMP.  It is harmless to set it without the JIT.  */
+int _gst_perf_map = 0;
+
 #ifdef ENABLE_JIT_TRANSLATION
 #include "lightning.h"
 #include "jitpriv.h"
@@ -335,6 +339,11 @@ static inline mst_Boolean emit_primitive (int primitive, int numArgs);
 static inline void emit_interrupt_check (int restartReg);
 static inline void generate_run_time_code (void);
 static inline void translate_method (OOP methodOOP, OOP receiverClass, int size);
+
+/* perf(1) support */
+static void perf_map_open (void);
+static void perf_map_record_method (method_entry *method);
+static void perf_map_release_method (method_entry *method);
 static void emit_basic_size_in_r0 (OOP classOOP, mst_Boolean tagged, int objectReg);
 
 /* Code generation functions for bytecodes */
@@ -623,6 +632,208 @@ generate_run_time_code (void)
 }
 
 
+/* Functions for describing translations to perf(1).
+
+   The map file is a text file with one "START SIZE NAME" line per
+   translation; perf reads it when it reports on a JIT-enabled process,
+   and later lines override earlier ones for the same address.  The
+   jitdump file follows the format described in the Linux kernel's
+   tools/perf/Documentation/jitdump-specification.txt; perf finds it
+   because we map it into the address space, which shows up in the
+   MMAP records of a `perf record -k mono' session.  */
+
+#define JITDUMP_MAGIC		0x4A695444
+#define JITDUMP_VERSION		1
+#define JITDUMP_CODE_LOAD	0
+
+#if defined __x86_64__
+#define JITDUMP_ELF_MACH	62	/* EM_X86_64 */
+#elif defined __i386__
+#define JITDUMP_ELF_MACH	3	/* EM_386 */
+#elif defined __powerpc__
+#define JITDUMP_ELF_MACH	20	/* EM_PPC */
+#elif defined __sparc__
+#define JITDUMP_ELF_MACH	2	/* EM_SPARC */
+#else
+#define JITDUMP_ELF_MACH	0	/* EM_NONE */
+#endif
+
+typedef struct jitdump_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t total_size;
+  uint32_t elf_mach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+}
+jitdump_header;
+
+typedef struct jitdump_code_load
+{
+  uint32_t id;
+  uint32_t total_size;
+  uint64_t timestamp;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t code_addr;
+  uint64_t code_size;
+  uint64_t code_index;
+}
+jitdump_code_load;
+
+static FILE *perf_map_file, *jitdump_file;
+static pid_t perf_map_pid;
+static uint64_t jitdump_code_index;
+
+void
+perf_map_open (void)
+{
+  char *fileName;
+
+  /* After a fork, leave the parent's files alone and start new ones.  */
+  if (perf_map_pid == getpid ())
+    return;
+
+  perf_map_pid = getpid ();
+  perf_map_file = jitdump_file = NULL;
+  jitdump_code_index = 0;
+
+  asprintf (&fileName, "/tmp/perf-%d.map", (int) perf_map_pid);
+  perf_map_file = fopen (fileName, "w");
+  if (!perf_map_file)
+    _gst_errorf ("Could not open %s for writing", fileName);
+  free (fileName);
+
+#if defined HAVE_SYS_MMAN_H && defined MAP_PRIVATE
+  if (_gst_perf_map & PERF_MAP_JITDUMP)
+    {
+      jitdump_header header;
+      PTR marker;
+
+      asprintf (&fileName, "/tmp/jit-%d.dump", (int) perf_map_pid);
+      jitdump_file = fopen (fileName, "w+");
+      if (!jitdump_file)
+        {
+          _gst_errorf ("Could not open %s for writing", fileName);
+          free (fileName);
+          return;
+        }
+
+      free (fileName);
+      memset (&header, 0, sizeof (header));
+      header.magic = JITDUMP_MAGIC;
+      header.version = JITDUMP_VERSION;
+      header.total_size = sizeof (header);
+      header.elf_mach = JITDUMP_ELF_MACH;
+      header.pid = perf_map_pid;
+      header.timestamp = _gst_get_ns_time ();
+      fwrite (&header, sizeof (header), 1, jitdump_file);
+      fflush (jitdump_file);
+
+      /* This mapping is never used, but its MMAP record is what tells
+         perf to look for the jitdump file.  */
+      marker = mmap (NULL, getpagesize (), PROT_READ | PROT_EXEC,
+		     MAP_PRIVATE, fileno (jitdump_file), 0);
+      if (marker == MAP_FAILED)
+        {
+          fclose (jitdump_file);
+          jitdump_file = NULL;
+        }
+    }
+#endif
+}
+
+void
+perf_map_record_method (method_entry *method)
+{
+  OOP methodOOP, methodClass, receiverClass;
+  const char *blockPrefix = "", *classSuffix = "", *receiverSuffix = "";
+  gst_compiled_method compiledMethod;
+  gst_method_info methodInfo;
+  char *name;
+
+  perf_map_open ();
+  methodOOP = method->methodOOP;
+  if (OOP_CLASS (methodOOP) == _gst_compiled_block_class)
+    {
+      methodOOP = ((gst_compiled_block) OOP_TO_OBJ (methodOOP))->method;
+      blockPrefix = "[] in ";
+    }
+
+  compiledMethod = (gst_compiled_method) OOP_TO_OBJ (methodOOP);
+  methodInfo = (gst_method_info) OOP_TO_OBJ (compiledMethod->descriptor);
+
+  /* Do not use %O for metaclasses, because it looks for the instance
+     class by scanning the whole OOP table.  */
+  methodClass = methodInfo->class;
+  if (IS_A_METACLASS (methodClass))
+    {
+      methodClass = METACLASS_INSTANCE (methodClass);
+      classSuffix = " class";
+    }
+
+  receiverClass = method->receiverClass;
+  if (IS_A_METACLASS (receiverClass))
+    {
+      receiverClass = METACLASS_INSTANCE (receiverClass);
+      receiverSuffix = " class";
+    }
+
+  asprintf (&name, "%s%O%s>>%#O [%O%s]", blockPrefix,
+	    methodClass, classSuffix, methodInfo->selector,
+	    receiverClass, receiverSuffix);
+
+  if (perf_map_file)
+    {
+      fprintf (perf_map_file, "%lx %lx %s\n",
+	       (unsigned long) method->nativeCode,
+	       (unsigned long) method->nativeSize, name);
+      fflush (perf_map_file);
+    }
+
+  if (jitdump_file)
+    {
+      jitdump_code_load record;
+      size_t nameSize = strlen (name) + 1;
+
+      record.id = JITDUMP_CODE_LOAD;
+      record.total_size = sizeof (record) + nameSize + method->nativeSize;
+      record.timestamp = _gst_get_ns_time ();
+      record.pid = record.tid = perf_map_pid;
+      record.vma = record.code_addr = (uintptr_t) method->nativeCode;
+      record.code_size = method->nativeSize;
+      record.code_index = jitdump_code_index++;
+      fwrite (&record, sizeof (record), 1, jitdump_file);
+      fwrite (name, nameSize, 1, jitdump_file);
+      fwrite (method->nativeCode, method->nativeSize, 1, jitdump_file);
+      fflush (jitdump_file);
+    }
+
+  free (name);
+}
+
+void
+perf_map_release_method (method_entry *method)
+{
+  /* The method might already have been garbage collected, so we cannot
+     print its name again.  perf uses the last entry for an address,
+     so this hides the stale one until the memory is reused.  jitdump
+     has no unload record; perf relies on the timestamps there.  */
+  perf_map_open ();
+  if (perf_map_file)
+    {
+      fprintf (perf_map_file, "%lx %lx <released translation>\n",
+	       (unsigned long) method->nativeCode,
+	       (unsigned long) method->nativeSize);
+      fflush (perf_map_file);
+    }
+}
+
+
 /* Functions for managing the translated methods' hash table */
 
 void
@@ -662,6 +873,7 @@ finish_method_entry (void)
   /* Shrink the method, and store it into the hash table */
   codePtr = (char *) jit_get_label ();
   jit_flush_code (current->nativeCode, codePtr);
+  current->nativeSize = codePtr - (char *) current->nativeCode;
 
   result =
     (method_entry *) xrealloc (current, codePtr - (char *) current);
@@ -678,6 +890,9 @@ finish_method_entry (void)
   methods_table[hashEntry] = result;
 
   obstack_free (&aux_data_obstack, NULL);
+  if (_gst_perf_map)
+    perf_map_record_method (result);
+
   return result;
 }
 
@@ -3853,6 +4068,8 @@ walk_and_remove_method (OOP methodOOP, method_entry **ptrNext)
       *ptrNext = method->next;
       method->next = released;
       released = method;
+      if (_gst_perf_map)
+	perf_map_release_method (method);
 
       /* Mark the method as freed */
       if (method->inlineCaches)
@@ -53,6 +53,15 @@
 #ifndef GST_XLAT_H
 #define GST_XLAT_H
 
+/* Bits for _gst_perf_map.  When PERF_MAP_FILE is set, every translation
+   is described in /tmp/perf-PID.map as soon as it is created; when
+   PERF_MAP_JITDUMP is set, a jitdump file including the native code is
+   written too, for use with `perf inject --jit'.  */
+#define PERF_MAP_FILE		1
+#define PERF_MAP_JITDUMP	2
+
+extern int _gst_perf_map
+  ATTRIBUTE_HIDDEN;
 
 #ifdef ENABLE_JIT_TRANSLATION
 
@@ -65,6 +74,7 @@ typedef struct method_entry
   OOP receiverClass;
   struct inline_cache *inlineCaches;
   struct ip_map *ipMap;
+  size_t nativeSize;
   int nativeCode[1];		/* type chosen randomly */
 }
 method_entry;
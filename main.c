@@ -94,8 +94,11 @@ static const char help_text[] =
   "\n   -v --version\t\t\t Print the Smalltalk version number and exit."
   "\n   -V --verbose\t\t\t Show names of loaded files and execution stats."
   "\n      --emacs-mode\t\t Execute as a `process' (from within Emacs)"
+  "\n      --jitdump\t\t Like --perf-map, and also write a jitdump file."
   "\n      --kernel-directory DIR\t Look for kernel files in directory DIR."
-  "\n      --no-user-files\t\t Don't read user customization files.\n"
+  "\n      --no-lex-ahead\t\t Scan files on the same thread as the compiler."
+  "\n      --no-user-files\t\t Don't read user customization files."
+  "\n      --perf-map\t\t Describe JIT-compiled methods in\n\t\t\t\t /tmp/perf-PID.map for perf(1).\n"
   "\n   -\t\t\t\t Read input from standard input explicitly."
   "\n"
   "\nFiles are loaded one after the other.  After the last one is loaded,"
@@ -127,6 +130,9 @@ static const char copyright_and_legal_stuff_text[] =
 #define OPT_NO_USER 3
 #define OPT_EMACS_MODE 4
 #define OPT_MAYBE_REBUILD 5
+#define OPT_PERF_MAP 6
+#define OPT_JITDUMP 7
+#define OPT_NO_LEX_AHEAD 8
 
 #define OPTIONS "-acDEf:ghiI:K:lL:QqrSvV"
 
@@ -137,14 +143,17 @@ static const struct option long_options[] = {
   {"execution-trace", 0, 0, 'E'},
   {"file", 0, 0, 'f'},
   {"kernel-directory", 1, 0, OPT_KERNEL_DIR},
+  {"no-lex-ahead", 0, 0, OPT_NO_LEX_AHEAD},
   {"no-user-files", 0, 0, OPT_NO_USER},
   {"no-gc-message", 0, 0, 'g'},
   {"help", 0, 0, 'h'},
+  {"jitdump", 0, 0, OPT_JITDUMP},
   {"maybe-rebuild-image", 0, 0, OPT_MAYBE_REBUILD},
   {"rebuild-image", 0, 0, 'i'},
   {"image-file", 1, 0, 'I'},
   {"kernel-file", 1, 0, 'K'},
   {"emacs-mode", 0, 0, OPT_EMACS_MODE},
+  {"perf-map", 0, 0, OPT_PERF_MAP},
   {"quiet", 0, 0, 'q'},
   {"no-messages", 0, 0, 'q'},
   {"silent", 0, 0, 'q'},
@@ -293,6 +302,18 @@ parse_args (int argc,
 	  flags |= GST_IGNORE_USER_FILES;
 	  break;
 
+	case OPT_PERF_MAP:
+	  gst_set_var (GST_PERF_MAP, 1);
+	  break;
+
+	case OPT_JITDUMP:
+	  gst_set_var (GST_PERF_MAP, 3);
+	  break;
+
+	case OPT_NO_LEX_AHEAD:
+	  gst_set_var (GST_LEX_AHEAD, 0);
+	  break;
+
 	case 'v':
 	  printf (copyright_and_legal_stuff_text, VERSION,
 		  PACKAGE_GIT_REVISION,
@@ -0,0 +1,5 @@
+Isolates_FILES = \
+packages/isolates/Isolate.st packages/isolates/IsolateTests.st 
+$(Isolates_FILES):
+$(srcdir)/packages/isolates/stamp-classes: $(Isolates_FILES)
+	touch $(srcdir)/packages/isolates/stamp-classes